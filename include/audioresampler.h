@@ -0,0 +1,37 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Cubic stereo resampler with dynamic rate control, keeping the audio queue filled without stuttering.
+#ifndef AUDIO_RESAMPLER_H__
+#define AUDIO_RESAMPLER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** Default maximum relative deviation of the resampling ratio used to correct the queue fill level. */
+#define AUDIO_RESAMPLER_MAX_DEVIATION 0.005
+
+/** Struct describing a Catmull-Rom resampler for interleaved stereo 16-bit samples. */
+struct audio_resampler {
+    double ratio; /**< Output frames per input frame without rate control. */
+    double max_deviation; /**< Maximum relative adjustment of the ratio, @see AUDIO_RESAMPLER_MAX_DEVIATION. */
+    double position; /**< Position of the next output frame between the second and third history frame. */
+    float history[4][2]; /**< Last four input frames. */
+    int16_t *output; /**< Output of the last call to audio_resampler_process(). */
+    size_t nr_output_frames; /**< Capacity of the output. */
+};
+
+bool create_audio_resampler(struct audio_resampler *, const double, const double, const double);
+bool free_audio_resampler(struct audio_resampler *);
+size_t audio_resampler_process(struct audio_resampler *, const int16_t *, const size_t, const double);
+
+#endif
+
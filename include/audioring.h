@@ -0,0 +1,40 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Wait-free ring buffer passing audio from the core to the SDL audio callback.
+#ifndef AUDIO_RING_H__
+#define AUDIO_RING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <SDL.h>
+
+/** Struct describing a ring buffer for a single producer and a single consumer thread. Positions run modulo twice the capacity, such that a full ring can be distinguished from an empty one. Reads and writes should be multiples of the audio frame size, such that partial writes never split a frame. */
+struct audio_ring {
+    uint8_t *data;
+    size_t nr_bytes; /**< Capacity, a power of two. */
+    SDL_atomic_t write_position; /**< Only advanced by the producer. */
+    SDL_atomic_t read_position; /**< Only advanced by the consumer. */
+    SDL_atomic_t nr_overflows; /**< Number of writes that did not fit entirely, the remainder is dropped. */
+    SDL_atomic_t nr_underruns; /**< Number of reads that could not be satisfied entirely. */
+};
+
+bool create_audio_ring(struct audio_ring *, const size_t);
+bool free_audio_ring(struct audio_ring *);
+size_t audio_ring_available(struct audio_ring *);
+size_t audio_ring_write(struct audio_ring *, const void *, const size_t);
+size_t audio_ring_read(struct audio_ring *, void *, const size_t);
+size_t audio_ring_peek(struct audio_ring *, const uint8_t **);
+void audio_ring_skip(struct audio_ring *, const size_t);
+void audio_ring_clear(struct audio_ring *);
+
+#endif
+
@@ -20,6 +20,7 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #include "retrogauntlet.h"
 #include "libretro.h"
+#include "workerpool.h"
 
 #ifdef _WIN32
 typedef HMODULE dl_t;
@@ -77,6 +78,66 @@ struct retro_core_memory_condition {
     uint64_t last_value;
 };
 
+/** Function evaluating a single memory condition for the given memory region, updating its last value. */
+typedef bool (*retro_core_condition_evaluate_t)(const uint8_t *, struct retro_core_memory_condition *);
+
+/** Struct describing a memory condition compiled to a specialized evaluation function. */
+struct retro_core_condition_op {
+    retro_core_condition_evaluate_t evaluate;
+    struct retro_core_memory_condition *condition;
+    size_t end; /**< Offset of the first byte after the condition's value. */
+};
+
+/** Struct describing consecutive condition operations that all read from the same memory region. */
+struct retro_core_condition_region {
+    size_t snapshot;
+    size_t first_op;
+    size_t nr_ops;
+    size_t max_end;
+};
+
+/** Enum describing the instructions of a compiled condition expression, which operate on a single boolean accumulator. */
+enum retro_core_condition_opcode {
+    CONDOP_LEAF = 0, /**< Set accumulator to the result of condition operation a. */
+    CONDOP_CONST = 1, /**< Set accumulator to a != 0. */
+    CONDOP_NOT = 2, /**< Negate accumulator. */
+    CONDOP_RISE = 3, /**< Set accumulator if it became true since the previous evaluation stored in state a. */
+    CONDOP_FALL = 4, /**< Set accumulator if it became false since the previous evaluation stored in state a. */
+    CONDOP_JUMP = 5, /**< Continue at instruction a. */
+    CONDOP_JUMP_IF_FALSE = 6, /**< Continue at instruction a if the accumulator is false. */
+    CONDOP_JUMP_IF_TRUE = 7, /**< Continue at instruction a if the accumulator is true. */
+    CONDOP_SEQ_SKIP = 8, /**< Continue at instruction c if sequence state a is not at step b. */
+    CONDOP_SEQ_ADVANCE = 9, /**< If the accumulator is true, advance sequence state a and only keep the accumulator true once all b steps are done. */
+    CONDOP_STORE = 10, /**< Store accumulator in state a. */
+    CONDOP_LOAD = 11 /**< Set accumulator to state a. */
+};
+
+/** Value of an edge state before its first evaluation, such that no edge is detected initially. */
+#define CONDITION_STATE_UNSET 2
+
+/** Struct describing a single instruction of a compiled condition expression, @see retro_core_condition_opcode. */
+struct retro_core_condition_instruction {
+    unsigned op; /**< @see retro_core_condition_opcode */
+    size_t a, b, c;
+};
+
+/** Struct describing conditions sorted by memory region and offset, such that every region is looked up once per check, and the expression combining them. */
+struct retro_core_condition_plan {
+    struct retro_core_condition_op *ops;
+    size_t nr_ops;
+    struct retro_core_condition_region *regions;
+    size_t nr_regions;
+    size_t *op_regions; /**< Region index for each operation. */
+    const uint8_t **region_data; /**< Memory of each region, resolved once per check. */
+    size_t *nr_region_data;
+
+    struct retro_core_condition_instruction *instructions;
+    size_t nr_instructions;
+    size_t max_instructions;
+    size_t *states; /**< Edge, sequence, and stored results of the expression. */
+    size_t nr_states;
+};
+
 /** Enum describing the mask condition for libretro core memory inspection. */
 enum retro_core_memory_mask_condition {
     MASK_IF_MASK_ALWAYS = 0,
@@ -98,6 +159,22 @@ enum retro_core_memory_data_condition {
     MASK_IF_DATA_LESS_CONST = 8
 };
 
+/** Struct describing a chunk of a memory snapshot that is compared and copied by a single job. */
+struct retro_core_snapshot_chunk {
+    size_t snapshot;
+    size_t begin;
+    size_t end;
+    size_t nr_candidates; /**< Number of mask values equal to one in this chunk after the comparison. */
+    size_t nr_dirty_pages; /**< Number of pages that differed from the previous snapshot. */
+};
+
+/** Struct describing an offset that survived a narrowed memory search, i.e., with mask value one. */
+struct retro_core_snapshot_candidate {
+    size_t snapshot;
+    size_t offset;
+    uint64_t value; /**< Little-endian value of up to 8 bytes at the offset during the last comparison. */
+};
+
 /** Struct wrapping a libretro core, based on RetroArch's dynamic.h. */
 struct retro_core {
     void (*retro_init)(void);
@@ -132,6 +209,23 @@ struct retro_core {
     uint8_t **snapshot_mask;
     size_t *nr_snapshot_data;
     size_t nr_snapshots;
+    uint64_t cpu_features; /**< RETRO_SIMD_* flags used to select snapshot kernels, @see snapshot_simd_kernel. */
+    
+    const uint8_t **snapshot_sources; /**< Core memory of each snapshot for the comparison in progress. */
+    struct retro_core_snapshot_chunk *snapshot_chunks;
+    size_t nr_snapshot_chunks;
+    size_t max_snapshot_chunks;
+    struct worker_pool snapshot_pool;
+    bool snapshot_pending;
+    unsigned compare_mask_condition; /**< @see retro_core_memory_mask_condition */
+    unsigned compare_data_condition; /**< @see retro_core_memory_data_condition */
+    unsigned compare_mask_action; /**< @see retro_core_memory_mask_action */
+    unsigned compare_size_value; /**< @see retro_core_memory_var_type */
+    uint64_t compare_const_value;
+    
+    struct retro_core_snapshot_candidate *snapshot_candidates; /**< Sorted by snapshot and offset, replaces the full snapshot comparison while active. */
+    size_t nr_snapshot_candidates;
+    bool snapshot_candidates_active;
 
     char *full_path;
     void *rom_data;
@@ -145,6 +239,14 @@ struct retro_core {
     double sample_rate;
 };
 
+/** Struct describing preallocated buffers for serialized core states, such that states can be saved every frame without allocating memory. */
+struct retro_core_state_pool {
+    uint8_t *data;
+    size_t nr_state_bytes; /**< Capacity of each state, with some headroom for cores whose state size varies. */
+    size_t nr_states;
+    size_t next_state;
+};
+
 bool load_core_from_file(struct retro_core *core,
                          const char *core_file, const char *rom_file, const char *options_file,
                          retro_environment_t setup_function,
@@ -156,8 +258,14 @@ bool load_core_from_file(struct retro_core *core,
 
 bool core_serialize_to_file(const char *, struct retro_core *);
 bool core_unserialize_from_file(struct retro_core *, const char *);
-bool core_load_conditions_from_file(struct retro_core_memory_condition **, size_t *, const char *);
+bool create_core_state_pool(struct retro_core_state_pool *, struct retro_core *, const size_t);
+bool free_core_state_pool(struct retro_core_state_pool *);
+const uint8_t *core_serialize_to_pool(struct retro_core_state_pool *, struct retro_core *, size_t *);
+bool core_load_conditions_from_file(struct retro_core_memory_condition **, size_t *, struct retro_core_condition_plan *, const char *);
 bool core_check_conditions(const struct retro_core *, struct retro_core_memory_condition *, const size_t, const bool);
+bool core_compile_conditions(struct retro_core_condition_plan *, struct retro_core_memory_condition *, const size_t);
+bool core_check_condition_plan(const struct retro_core *, struct retro_core_condition_plan *);
+bool free_core_condition_plan(struct retro_core_condition_plan *);
 bool set_core_variables(struct retro_core *, const struct retro_variable *);
 bool set_core_variable(struct retro_core *, const char *, const char *);
 const char *get_core_variable(struct retro_core *, const struct retro_variable *);
@@ -170,6 +278,9 @@ bool free_core(struct retro_core *);
 
 bool free_core_snapshots(struct retro_core *);
 bool core_take_and_compare_snapshots(struct retro_core *, const unsigned, const unsigned, const unsigned, const unsigned, const uint64_t);
+bool core_start_snapshot_comparison(struct retro_core *, const unsigned, const unsigned, const unsigned, const unsigned, const uint64_t);
+bool core_wait_for_snapshots(struct retro_core *);
+bool core_verify_snapshot_kernels(const uint64_t);
 
 #endif
 
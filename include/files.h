@@ -12,10 +12,15 @@ You should have received a copy of the GNU General Public License along with Ret
 #ifndef FILES_H__
 #define FILES_H__
 
+#include <stdint.h>
+#include <stddef.h>
+
 char *expand_to_full_path(const char *);
 int does_file_exist(const char *);
 char *combine_paths(const char *, const char *);
 int create_directory(const char *);
+int hash_file(const char *, uint64_t *, size_t *);
+int copy_file(const char *, const char *);
 
 #endif
 
@@ -0,0 +1,50 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//High-resolution pacing of emulated frames against the display.
+#ifndef FRAME_PACER_H__
+#define FRAME_PACER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <SDL.h>
+
+/** Enum describing how emulated frames are paced. */
+enum frame_pacer_policy {
+    FRAME_PACER_VSYNC = 0, /**< Lock to vsync if the display refresh rate matches the core, otherwise use the timer with vsync enabled. */
+    FRAME_PACER_FREE_RUN = 1, /**< Disable vsync and only use the timer. */
+    FRAME_PACER_ADAPTIVE = 2 /**< Lock to adaptive vsync if the display refresh rate matches the core, otherwise disable vsync and use the timer. */
+};
+
+/** Struct describing the pacing state of emulated frames, using the SDL performance counter. */
+struct frame_pacer {
+    unsigned policy; /**< @see frame_pacer_policy */
+    double frequency; /**< Performance counter ticks per second. */
+    double frame_ticks; /**< Performance counter ticks per emulated frame. */
+    double refresh_rate; /**< Display refresh rate in Hz, 0 if unknown. */
+    int swap_interval; /**< Swap interval in use, negative for adaptive vsync. */
+    bool display_locked; /**< Whether the buffer swap paces emulation instead of the timer. */
+    uint64_t spin_ticks; /**< Time before a deadline that is spent spinning instead of sleeping. */
+    uint64_t start_counter; /**< Counter value of the first frame, 0 to restart timing at the next frame. */
+    uint64_t nr_frames; /**< Number of frames since the start of timing. */
+    bool presented; /**< Whether the current frame ends with a buffer swap, otherwise the timer paces it. */
+    size_t max_skip; /**< Maximum number of frames to run without video to catch up, further frames are dropped. */
+    uint64_t nr_skipped_frames; /**< Number of frames run without video. */
+    uint64_t nr_dropped_frames; /**< Number of frames that were not emulated because we were too far behind. */
+};
+
+bool create_frame_pacer(struct frame_pacer *, const unsigned, const size_t);
+void frame_pacer_restart(struct frame_pacer *, const bool);
+void frame_pacer_begin_frame(struct frame_pacer *, SDL_Window *, const double);
+size_t frame_pacer_end_frame(struct frame_pacer *);
+
+#endif
+
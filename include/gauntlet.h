@@ -17,6 +17,12 @@ You should have received a copy of the GNU General Public License along with Ret
 #include "core.h"
 #include "sdlglcoreinterface.h"
 
+//Largest number of frames a gauntlet may run ahead, as each costs an additional emulated frame per displayed frame.
+#define MAX_RETRO_GAUNTLET_RUNAHEAD_FRAMES 4
+
+//Frame rate at which frames are counted if the core does not report one.
+#define RETRO_GAUNTLET_NOMINAL_FPS 60.0
+
 enum gauntlet_status {
     RETRO_GAUNTLET_OFF = 0,
     RETRO_GAUNTLET_RUNNING = 1,
@@ -47,22 +53,33 @@ struct gauntlet {
     bool enable_mouse;
     int mouse_button_mask;
     bool enable_controller;
+    size_t nr_runahead_frames;
     bool enable_debug;
     
     enum gauntlet_status status;
     uint32_t par_time;
     uint32_t start_time, end_time;
+    bool enable_frame_timing; /**< Time by the number of emulated frames instead of wall-clock time. */
+    uint64_t nr_frames; /**< Number of emulated frames since the gauntlet started. */
+    double frame_ms; /**< Sum of the durations in ms of all emulated frames, at the core's frame rate when each was emulated. */
+    uint32_t frame_time; /**< Finish time in ms derived from @see frame_ms. */
+    bool nominal_frame_rate; /**< Whether some frames were counted at @see RETRO_GAUNTLET_NOMINAL_FPS as the core reported no frame rate. */
     struct retro_core_memory_condition *win_conditions;
     size_t nr_win_conditions;
     struct retro_core_memory_condition *lose_conditions;
     size_t nr_lose_conditions;
+    struct retro_core_condition_plan win_plan;
+    struct retro_core_condition_plan lose_plan;
 };
 
 bool free_gauntlet(struct gauntlet *);
 bool create_gauntlet(struct gauntlet *, const char *, const char *);
 bool gauntlet_start(struct gauntlet *, struct sdl_gl_core_interface *);
 bool gauntlet_check_status(struct gauntlet *, struct sdl_gl_core_interface *);
+void gauntlet_count_frame(struct gauntlet *, const double);
 bool gauntlet_stop(struct gauntlet *);
+uint32_t gauntlet_get_time(const struct gauntlet *);
+uint32_t gauntlet_get_wall_time(const struct gauntlet *);
 bool read_gauntlet_playlist(struct gauntlet **, size_t *, const char *);
 
 #endif
@@ -23,6 +23,34 @@ You should have received a copy of the GNU General Public License along with Ret
 #include "sdlglcoreinterface.h"
 #include "gauntlet.h"
 #include "menu.h"
+#include "framepacer.h"
+#include "triplebuffer.h"
+#include "audioring.h"
+
+//Longest time in milliseconds the menu sleeps without input or network activity, bounding the delay of lobby broadcasts.
+#define RETRO_GAUNTLET_MENU_WAIT_MS 250
+
+//Interval in milliseconds at which the host sends more file data to clients while synchronizing files.
+#define RETRO_GAUNTLET_SYNC_WAIT_MS 10
+
+//Longest time in milliseconds the render thread waits for a frame from the emulation thread, bounding the delay of input and network handling.
+#define RETRO_GAUNTLET_FRAME_WAIT_MS 20
+
+//Interval in milliseconds at which the client network thread checks whether it should stop.
+#define RETRO_GAUNTLET_CLIENT_WAIT_MS 10
+
+//Maximum number of host messages applied per frame, bounding the cost of networking while running a core.
+#define RETRO_GAUNTLET_CLIENT_MESSAGES_PER_FRAME 16
+
+//Size in bytes of the queue of received host messages, the client network thread stops reading from the socket while it is full.
+#define RETRO_GAUNTLET_CLIENT_QUEUE_SIZE (16*MAX_RETRO_GAUNTLET_MSG_DATA)
+
+/** Struct describing a queue of complete messages passed from a single network thread to the game thread. */
+struct gauntlet_message_queue {
+    struct audio_ring ring; /**< Message bytes, the ring buffer is not specific to audio. */
+    SDL_sem *room; /**< Posted by the game thread when it releases space while the network thread waits for it. */
+    SDL_atomic_t waiting; /**< Set by the network thread while it waits for space. */
+};
 
 //Network players and messages.
 enum message_types {
@@ -34,14 +62,41 @@ enum message_types {
     RETRO_GAUNTLET_MSG_FILE_START = 5,
     RETRO_GAUNTLET_MSG_FILE_DATA = 6,
     RETRO_GAUNTLET_MSG_FILE_END = 7,
-    RETRO_GAUNTLET_MSG_MAX = 8
+    RETRO_GAUNTLET_MSG_MANIFEST = 8,
+    RETRO_GAUNTLET_MSG_MISSING = 9,
+    RETRO_GAUNTLET_MSG_MAX = 10
+};
+
+//Longest time in milliseconds the host waits for clients to report which files they are missing, or to receive more file data.
+#define RETRO_GAUNTLET_SYNC_TIMEOUT_MS 10000
+
+//Maximum number of files the host offers to clients.
+#define MAX_RETRO_GAUNTLET_SYNC_FILES 32
+
+//Number of bytes of file data the host keeps queued per client, well below the amount at which clients are dropped.
+#define RETRO_GAUNTLET_SYNC_QUEUE_SIZE (1 << 20)
+
+//Directory inside the data directory where clients keep received files by content hash.
+#define RETRO_GAUNTLET_CACHE_DIRECTORY "cache"
+
+/** File the host offers to clients before starting a gauntlet. */
+struct gauntlet_sync_file {
+    char *file; /**< Full path of the file. */
+    const char *name; /**< Path relative to the data directory, points into file. */
+    uint64_t hash; /**< FNV-1a hash of the contents, @see hash_file. */
+    uint32_t size;
 };
 
 struct gauntlet_player {
     char name[NR_RETRO_GAUNTLET_NAME + 1];
     uint32_t finish_time;
+    uint32_t finish_wall_time;
     uint32_t points, last_points;
     enum gauntlet_status finish_state;
+    bool sync_pending; /**< Whether the host waits for this player to report missing files. */
+    uint32_t sync_missing; /**< Bit mask of sync files the host still has to send to this player. */
+    size_t sync_offset; /**< Number of bytes of the first missing file sent so far. */
+    uint32_t sync_time; /**< Time at which the host last sent file data to this player. */
     
     uint8_t data[MAX_RETRO_GAUNTLET_MSG_DATA];
     size_t nr_data;
@@ -61,16 +116,41 @@ struct gauntlet_game {
     void *client;
     void *host;
     struct blowfish fish;
-    struct gauntlet_player players[MAX_RETRO_GAUNTLET_CLIENTS + 1];
-    int player_indices[MAX_RETRO_GAUNTLET_CLIENTS + 1];
+    struct gauntlet_player *players; /**< The local player followed by one player per host client slot. */
+    int *player_indices;
+    int nr_players;
     uint8_t message_buffer[MAX_RETRO_GAUNTLET_MSG_DATA];
     FILE *client_recv_fid;
     char *client_recv_file;
     bool is_host_gauntlet_running;
+    struct gauntlet_sync_file *sync_files; /**< Files in the last manifest sent by the host. */
+    size_t nr_sync_files;
+
+    //Network thread for clients, receiving and decrypting messages from the host.
+    SDL_Thread *client_thread;
+    SDL_mutex *client_mutex; /**< Held while accessing the client socket. */
+    SDL_atomic_t client_quit; /**< Set to request the client network thread to stop. */
+    SDL_atomic_t client_active; /**< Cleared by the client network thread when the connection to the host is lost. */
+    struct gauntlet_player client_reader; /**< Message being received by the client network thread. */
+    struct gauntlet_message_queue client_messages; /**< Complete messages passed from the client network thread to the game thread. */
+    uint8_t *deferred_messages; /**< Messages received while running a core, applied once the gauntlet is finished. */
+    size_t nr_deferred_messages;
+    size_t max_deferred_messages;
+
+    //Network thread for hosts, waiting for network activity while the game thread waits for input.
+    SDL_Thread *host_thread;
+    SDL_sem *host_wait_start; /**< Posted by the game thread when the host network thread should wait for the network. */
+    SDL_sem *host_wait_done; /**< Posted by the host network thread when it no longer uses the host. */
+    SDL_atomic_t host_waiting; /**< Cleared by the game thread to stop waiting for the network. */
+    SDL_atomic_t host_quit; /**< Set to request the host network thread to stop. */
 
     char lobby_text[NR_RETRO_GAUNTLET_MENU_TEXT + 1];
     char last_lobby_text[NR_RETRO_GAUNTLET_MENU_TEXT + 1];
     uint32_t last_lobby_update_time;
+    int nr_lobby_clients; /**< Number of active clients when the lobby was last updated. */
+    bool lobby_changed; /**< Whether the host needs to rebuild the lobby text. */
+    bool menu_changed; /**< Whether the menu text needs to be regenerated. */
+    enum retrogauntlet_menu_state last_menu_state;
 
     //Variables related to setting up cores.
     unsigned snapshot_mask_condition;
@@ -81,10 +161,20 @@ struct gauntlet_game {
 
     //SDL output window and related variables.
     SDL_Window *window;
-    Uint32 start_ticks;
-    Uint32 nr_frames;
+    struct frame_pacer pacer;
     bool fullscreen;
     bool keep_running;
+
+    //Emulation thread for software-rendered cores.
+    SDL_Thread *emulation_thread;
+    SDL_mutex *emulation_mutex; /**< Held while the emulation thread accesses the core. */
+    SDL_atomic_t emulation_quit; /**< Set to request the emulation thread to stop. */
+    SDL_atomic_t emulation_active; /**< Cleared by the emulation thread when the gauntlet stops running. */
+    bool emulation_threaded; /**< Whether core callbacks are called from the emulation thread. */
+    struct frame_pacer emulation_pacer;
+    struct video_triple_buffer emulation_frames;
+    struct retro_game_geometry emulation_geometry; /**< Geometry set by the core, applied by the render thread. */
+    SDL_atomic_t emulation_geometry_changed;
 };
 
 void game_draw_message_to_screen(struct gauntlet_game *, const char *, ...);
@@ -94,6 +184,8 @@ bool free_game(struct gauntlet_game *);
 void game_change_gauntlet_selection(struct gauntlet_game *, const int);
 void game_select_rand_gauntlet(struct gauntlet_game *);
 bool game_stop_gauntlet(struct gauntlet_game *);
+bool game_start_emulation_thread(struct gauntlet_game *);
+bool game_stop_emulation_thread(struct gauntlet_game *);
 bool game_start_gauntlet(struct gauntlet_game *, const char *);
 void game_update_menu_text(struct gauntlet_game *);
 void game_update(struct gauntlet_game *);
@@ -103,12 +195,18 @@ bool game_start_host(struct gauntlet_game *);
 bool game_stop_host(struct gauntlet_game *);
 bool game_update_host(struct gauntlet_game *);
 bool game_host_start_gauntlet(struct gauntlet_game *);
+bool game_host_add_sync_file(struct gauntlet_game *, const char *);
+void game_clear_sync_files(struct gauntlet_game *);
+bool game_host_queue_missing_files(struct gauntlet_game *, struct gauntlet_player *, const uint8_t *, const size_t);
 
 bool game_start_client(struct gauntlet_game *, const char *);
 bool game_stop_client(struct gauntlet_game *);
 bool game_update_client(struct gauntlet_game *);
+bool game_client_apply_manifest(struct gauntlet_game *, const uint8_t *, const size_t);
+bool game_cache_file(struct gauntlet_game *, const char *);
 
 bool create_player(struct gauntlet_player *);
+bool game_reserve_players(struct gauntlet_game *, const int);
 
 #endif
 
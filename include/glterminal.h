@@ -0,0 +1,42 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//OpenGL text terminal drawing code page 437 glyphs from a texture atlas.
+#ifndef GL_TERMINAL_H__
+#define GL_TERMINAL_H__
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <SDL.h>
+
+#include "glvideo.h"
+
+/** Dimensions in pixels of a single VGA text mode glyph. */
+#define GL_TERMINAL_GLYPH_WIDTH 9
+#define GL_TERMINAL_GLYPH_HEIGHT 16
+
+/** Struct describing a text terminal of character cells, rendered by a shader looking up glyphs in a 16x16 atlas. */
+struct gl_terminal {
+    unsigned width, height; /**< Number of character cells. */
+    GLuint glyph_texture; /**< Atlas of all 256 glyphs. */
+    GLuint cell_texture; /**< Character of each cell. */
+    GLuint program;
+    GLuint vertex_shader;
+    GLuint fragment_shader;
+    GLuint vertex_array;
+};
+
+bool create_gl_terminal(struct gl_terminal *, const unsigned, const unsigned);
+bool free_gl_terminal(struct gl_terminal *);
+void gl_terminal_draw(struct gl_terminal *, const uint8_t *, const SDL_Color, const SDL_Color, struct gl_video *);
+
+#endif
+
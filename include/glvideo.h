@@ -19,6 +19,15 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #include "retrogauntlet.h"
 
+/** Number of pixel buffer objects used to stream software-rendered frames. */
+#define NR_VIDEO_PIXEL_BUFFERS 3
+
+/** Maximum number of separately uploaded spans of changed rows per frame. */
+#define MAX_VIDEO_DIRTY_SPANS 16
+
+/** Changed rows separated by at most this many unchanged rows are uploaded together. */
+#define VIDEO_DIRTY_ROW_GAP 8
+
 struct gl_video {
     GLuint base_width, base_height;
     GLuint max_width, max_height;
@@ -33,6 +42,22 @@ struct gl_video {
     GLuint texture;
     GLuint depth_stencil_buffer;
     GLuint frame_buffer;
+
+    //Pixel buffers for streaming software-rendered frames to the texture.
+    GLuint pixel_buffers[NR_VIDEO_PIXEL_BUFFERS];
+    uint8_t *pixel_buffer_maps[NR_VIDEO_PIXEL_BUFFERS]; /**< Persistent mappings, NULL without GL_ARB_buffer_storage. */
+    GLsync pixel_buffer_fences[NR_VIDEO_PIXEL_BUFFERS]; /**< Signalled once the upload from a persistently mapped buffer is complete. */
+    size_t nr_pixel_buffer_bytes;
+    unsigned i_pixel_buffer;
+    uint64_t upload_ticks; /**< Performance counter ticks spent uploading frames. */
+    uint64_t nr_uploads;
+
+    //Copy of the previous software-rendered frame to detect changed rows.
+    uint8_t *previous_frame;
+    size_t nr_previous_frame_bytes;
+    unsigned previous_width, previous_height; /**< Dimensions of the previous frame, 0 to upload the next frame entirely. */
+    bool dirty; /**< Whether the texture changed since it was last rendered. */
+    bool stream_frames; /**< Whether software-rendered core frames are streamed through pixel buffers, set only for core video. */
     
     //OpenGL scene.
     GLuint program;
@@ -52,6 +77,7 @@ bool free_video_shaders(struct gl_video *);
 bool video_set_geometry(struct gl_video *, const struct retro_game_geometry *);
 bool video_set_window(struct gl_video *, const unsigned, const unsigned);
 bool video_set_pixel_format(struct gl_video *, const enum retro_pixel_format);
+GLuint gl_compile_shader(const GLchar *, const GLuint);
 void video_bind_frame_buffer(struct gl_video *);
 void video_unbind_frame_buffer(struct gl_video *);
 void video_render(const struct gl_video *);
@@ -60,6 +86,7 @@ bool create_video_buffers(struct gl_video *);
 bool free_video(struct gl_video *);
 bool create_video(struct gl_video *);
 void video_refresh_from_libretro(struct gl_video *, const void *, unsigned, unsigned, size_t);
+double video_get_mean_upload_time(const struct gl_video *);
 
 #endif
 
@@ -17,9 +17,17 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #include "retrogauntlet.h"
 #include "glvideo.h"
+#include "glterminal.h"
 
 #define NR_RETRO_GAUNTLET_MENU_TEXT 4096
 
+//Largest number of frames that may be skipped in a row to catch up with the display.
+#define MAX_RETRO_GAUNTLET_FRAME_SKIP 10
+
+//Range of the audio latency budget in milliseconds, the lower bound fits three of the smallest device buffers at 48 kHz.
+#define MIN_RETRO_GAUNTLET_AUDIO_LATENCY 16
+#define MAX_RETRO_GAUNTLET_AUDIO_LATENCY 500
+
 enum retrogauntlet_menu_state {
     RETRO_GAUNTLET_STATE_SELECT_GAUNTLET = 0,
     RETRO_GAUNTLET_STATE_RUN_CORE       = 1,
@@ -60,6 +68,10 @@ struct retrogauntlet_menu {
     char password[NR_RETRO_GAUNTLET_PASSWORD + 1];
     char player_name[NR_RETRO_GAUNTLET_NAME + 1];
     int network_port;
+    unsigned frame_pacing; /**< @see frame_pacer_policy */
+    unsigned max_frame_skip;
+    bool emulation_thread; /**< Whether software-rendered cores run on a separate thread. */
+    unsigned audio_latency; /**< Audio latency budget in milliseconds. */
 
     bool mixer_enabled;
     struct soundboard win_board, lose_board, login_board;
@@ -69,8 +81,8 @@ struct retrogauntlet_menu {
     Mix_Music *music;
     uint32_t music_position;
     uint32_t music_start_time;
-    SDL_Surface *surface;
     struct gl_video video;
+    struct gl_terminal terminal_renderer; /**< Draws the terminal into the texture of video. */
     SDL_Color front_color, back_color;
     char text[NR_RETRO_GAUNTLET_MENU_TEXT + 1];
     char last_text[NR_RETRO_GAUNTLET_MENU_TEXT + 1];
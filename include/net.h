@@ -21,6 +21,7 @@ bool client_is_client_active(void *);
 bool client_is_client_new(void *);
 bool client_connect_to_host(void *, const char *, const int);
 bool client_listen(void *, const int);
+bool client_wait(void *, const int);
 bool client_send(void *, const void *, size_t);
 bool client_set_blocking(void *, const bool);
 size_t client_get_nr_data(void *);
@@ -33,6 +34,8 @@ bool allocate_host(void **, const int, const int);
 bool host_send(void *, void *, const void *, size_t);
 bool host_broadcast(void *, const void *, const size_t);
 bool host_listen(void *, const int);
+bool host_wait(void *, const int);
+bool host_interrupt(void *);
 bool host_remove_client(void *, const int);
 bool host_is_host_active(void *);
 bool host_is_client_active(void *, const int);
@@ -40,6 +43,7 @@ bool host_is_client_new(void *, const int);
 bool host_set_blocking(void *, const bool);
 bool host_set_accepts_clients(void *, const bool);
 int host_get_active_client_index(void *, int);
+size_t host_get_nr_queued(void *, void *);
 void *host_get_client(void *, int);
 void host_fprintf(FILE *, void *);
 int host_sprintf(char *, void *);
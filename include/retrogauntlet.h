@@ -45,6 +45,7 @@ You should have received a copy of the GNU General Public License along with Ret
 #define INFO_FILE stderr
 #define CORE_FILE stderr
 #define MEM_FILE stdout
+#define BENCH_FILE stdout
 
 #define NR_RETRO_GAUNTLET_PASSWORD 16
 #define NR_RETRO_GAUNTLET_NAME 16
@@ -53,7 +54,8 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #define RETRO_GAUNTLET_NET_HEADER 0xf1b2
 
-#define MAX_RETRO_GAUNTLET_CLIENTS 64
+//Hosts only allocate client and player slots as players connect.
+#define MAX_RETRO_GAUNTLET_CLIENTS 1024
 
 #define IS_COMMENT_LINE(line) (strlen(line) == 0 || line[0] == '#' || line[0] == ';' || line[0] == '/')
 
@@ -64,6 +66,8 @@ bool retrogauntlet_keep_running();
 bool retrogauntlet_fullscreen();
 bool retrogauntlet_sdl_event(const SDL_Event);
 bool retrogauntlet_frame_update();
+bool retrogauntlet_verify_snapshot_kernels();
+bool retrogauntlet_benchmark(const char *, const char *, const size_t);
 
 #endif
 
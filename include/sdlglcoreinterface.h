@@ -17,6 +17,8 @@ You should have received a copy of the GNU General Public License along with Ret
 #include "libretro.h"
 #include "glvideo.h"
 #include "core.h"
+#include "audioring.h"
+#include "audioresampler.h"
 
 #define RETRO_DEVICE_JOYPAD_NR_BUTTONS 16
 
@@ -26,14 +28,26 @@ struct sdl_gl_core_interface {
 
     //Audio state.
     SDL_AudioDeviceID audio_device_id;
-    unsigned audio_latency;
+    unsigned audio_latency; /**< Minimum audio latency requested by the core in milliseconds. */
+    unsigned audio_latency_target; /**< Audio latency budget in milliseconds. */
+    double audio_queued_latency; /**< Latency of the most recently queued audio in milliseconds. */
+    double audio_queued_latency_sum;
+    uint64_t nr_audio_latency_samples;
     SDL_AudioSpec audio_spec;
-    uint8_t *audio_buffer;
-    size_t nr_audio_buffer;
-    size_t audio_buffer_start, audio_buffer_available;
+    struct audio_ring audio_ring; /**< Filled by the core, emptied by the SDL audio callback. */
+    struct audio_resampler audio_resampler; /**< Converts from the core to the device sample rate. */
 
     //Core state.
     bool core_keep_running;
+    bool core_skip_video; /**< Whether the core is running a frame that will not be shown. */
+    bool core_skip_audio; /**< Whether the core is running a frame that will not be heard. */
+    bool core_fast_states; /**< Whether serialized states are only used for run-ahead. */
+
+    //Run-ahead state.
+    size_t nr_runahead_frames; /**< Number of frames to run ahead of the actual state, 0 to disable. */
+    struct retro_core_state_pool runahead_states;
+    uint64_t runahead_ticks; /**< Performance counter ticks spent on running ahead. */
+    uint64_t nr_runahead_runs;
     struct retro_core core;
     retro_keyboard_event_t core_keyboard_callback;
     retro_frame_time_callback_t core_frame_time_callback;
@@ -76,7 +90,11 @@ struct sdl_gl_core_interface {
 
 bool create_sdl_gl_if(struct sdl_gl_core_interface *);
 bool sdl_gl_if_create_core_buffers(struct sdl_gl_core_interface *);
+bool sdl_gl_if_create_headless_core_buffers(struct sdl_gl_core_interface *);
 bool sdl_gl_if_reset_audio(struct sdl_gl_core_interface *);
+double sdl_gl_if_get_mean_audio_latency(const struct sdl_gl_core_interface *);
+bool sdl_gl_if_start_runahead(struct sdl_gl_core_interface *, const size_t);
+bool sdl_gl_if_run_frame(struct sdl_gl_core_interface *);
 int16_t sdl_gl_if_get_input_state(struct sdl_gl_core_interface *, const unsigned, const unsigned);
 bool sdl_gl_if_handle_event(struct sdl_gl_core_interface *, const SDL_Event);
 size_t audio_refresh(struct sdl_gl_core_interface *, const int16_t *, size_t);
@@ -0,0 +1,30 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//SSE2/AVX2 kernels for updating libretro core memory snapshot masks.
+#ifndef SNAPSHOT_SIMD_H__
+#define SNAPSHOT_SIMD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** Kernel updating the snapshot mask m_p for the first nr_offsets byte offsets given old data o_p and new data n_p, @see core_start_snapshot_comparison. Does not support MASK_THEN_LOG. */
+typedef void (*snapshot_kernel_t)(uint8_t *m_p, const uint8_t *o_p, const uint8_t *n_p, const size_t nr_offsets,
+                                  const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action,
+                                  const unsigned size_value, const uint64_t const_value);
+
+bool snapshot_data_condition(const unsigned, const uint64_t, const uint64_t, const uint64_t);
+uint8_t snapshot_mask_action(const unsigned, const uint8_t);
+snapshot_kernel_t snapshot_simd_kernel(const uint64_t);
+const char *snapshot_simd_kernel_name(const uint64_t);
+
+#endif
+
@@ -0,0 +1,47 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Lock-free triple buffer passing video frames from the emulation thread to the render thread.
+#ifndef TRIPLE_BUFFER_H__
+#define TRIPLE_BUFFER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <SDL.h>
+
+/** Flag set on the shared frame index when it contains a frame that has not been read yet. */
+#define TRIPLE_BUFFER_NEW 4
+
+/** Struct describing a video frame stored in a triple buffer. */
+struct video_frame {
+    uint8_t *data;
+    unsigned width, height;
+    size_t pitch;
+};
+
+/** Struct describing a triple buffer for a single producer and a single consumer. The producer always has a frame to write to and the consumer always reads the most recent complete frame, such that the producer never waits for the consumer. */
+struct video_triple_buffer {
+    struct video_frame frames[3];
+    size_t nr_frame_bytes; /**< Capacity of each frame. */
+    SDL_atomic_t shared; /**< Index of the frame exchanged between producer and consumer, @see TRIPLE_BUFFER_NEW. */
+    int write_index; /**< Only accessed by the producer. */
+    int read_index; /**< Only accessed by the consumer. */
+    SDL_sem *ready; /**< Signalled when a new frame becomes available, @see video_triple_buffer_wait. */
+};
+
+bool create_video_triple_buffer(struct video_triple_buffer *, const size_t);
+bool free_video_triple_buffer(struct video_triple_buffer *);
+bool video_triple_buffer_write(struct video_triple_buffer *, const void *, const unsigned, const unsigned, const size_t, const size_t);
+const struct video_frame *video_triple_buffer_read(struct video_triple_buffer *);
+bool video_triple_buffer_wait(struct video_triple_buffer *, const uint32_t);
+
+#endif
+
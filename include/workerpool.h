@@ -0,0 +1,44 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Pool of SDL worker threads processing batches of independent jobs.
+#ifndef WORKER_POOL_H__
+#define WORKER_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL.h>
+
+/** Function executed for every job index of a batch, receiving the batch data pointer. */
+typedef void (*worker_job_t)(void *, const size_t);
+
+/** Struct describing a pool of worker threads. The thread calling worker_pool_wait() also processes jobs. */
+struct worker_pool {
+    SDL_Thread **threads;
+    size_t nr_threads;
+    SDL_mutex *mutex;
+    SDL_cond *work_cond;
+    SDL_cond *done_cond;
+
+    worker_job_t job;
+    void *job_data;
+    size_t nr_jobs;
+    size_t next_job;
+    size_t nr_jobs_done;
+    bool quit;
+};
+
+bool create_worker_pool(struct worker_pool *, const size_t);
+bool free_worker_pool(struct worker_pool *);
+bool worker_pool_start(struct worker_pool *, worker_job_t, void *, const size_t);
+bool worker_pool_wait(struct worker_pool *);
+
+#endif
+
@@ -0,0 +1,103 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "retrogauntlet.h"
+#include "audioresampler.h"
+
+bool create_audio_resampler(struct audio_resampler *resampler, const double input_rate, const double output_rate, const double max_deviation) {
+    if (!resampler || input_rate <= 0.0 || output_rate <= 0.0 || max_deviation < 0.0 || max_deviation >= 0.5) {
+        fprintf(ERROR_FILE, "create_audio_resampler: Invalid resampler, rates, or deviation!\n");
+        return false;
+    }
+
+    memset(resampler, 0, sizeof(struct audio_resampler));
+    resampler->ratio = output_rate/input_rate;
+    resampler->max_deviation = max_deviation;
+    resampler->position = 0.0;
+
+    fprintf(INFO_FILE, "Resampling audio from %.1f Hz to %.1f Hz with %.2f%% rate control.\n", input_rate, output_rate, 100.0*max_deviation);
+
+    return true;
+}
+
+bool free_audio_resampler(struct audio_resampler *resampler) {
+    if (!resampler) {
+        fprintf(ERROR_FILE, "free_audio_resampler: Invalid resampler!\n");
+        return false;
+    }
+
+    if (resampler->output) free(resampler->output);
+
+    memset(resampler, 0, sizeof(struct audio_resampler));
+
+    return true;
+}
+
+static inline int16_t clamp_sample(const float s) {
+    return (int16_t)(s > 32767.0f ? 32767.0f : (s < -32768.0f ? -32768.0f : s));
+}
+
+//Resample interleaved stereo frames into resampler->output, given the fill level in [0, 1] of the queue we are writing to.
+size_t audio_resampler_process(struct audio_resampler *resampler, const int16_t *data, const size_t nr_frames, const double fill) {
+    if (!resampler || !data) return 0;
+
+    //Produce more frames if the queue is less than half full and fewer if it is more than half full.
+    const double deviation = resampler->max_deviation*(1.0 - 2.0*(fill < 0.0 ? 0.0 : (fill > 1.0 ? 1.0 : fill)));
+    const double step = 1.0/(resampler->ratio*(1.0 + deviation));
+    const size_t nr_max_output = (size_t)ceil((double)nr_frames/step) + 2;
+
+    if (nr_max_output > resampler->nr_output_frames) {
+        int16_t *output = (int16_t *)realloc(resampler->output, 2*sizeof(int16_t)*nr_max_output);
+
+        if (!output) {
+            fprintf(ERROR_FILE, "audio_resampler_process: Unable to allocate %zu frames!\n", nr_max_output);
+            return 0;
+        }
+
+        resampler->output = output;
+        resampler->nr_output_frames = nr_max_output;
+    }
+
+    float (*h)[2] = resampler->history;
+    double t = resampler->position;
+    size_t nr_output = 0;
+
+    for (size_t i = 0; i < nr_frames; ++i) {
+        memmove(h[0], h[1], 3*sizeof(h[0]));
+        h[3][0] = (float)data[2*i + 0];
+        h[3][1] = (float)data[2*i + 1];
+
+        //Interpolate between h[1] and h[2] for both channels at once.
+        for (; t < 1.0 && nr_output < resampler->nr_output_frames; t += step) {
+            const float x = (float)t;
+
+            for (int c = 0; c < 2; ++c) {
+                const float a = -0.5f*h[0][c] + 1.5f*h[1][c] - 1.5f*h[2][c] + 0.5f*h[3][c];
+                const float b = h[0][c] - 2.5f*h[1][c] + 2.0f*h[2][c] - 0.5f*h[3][c];
+                const float d = 0.5f*(h[2][c] - h[0][c]);
+
+                resampler->output[2*nr_output + c] = clamp_sample(((a*x + b)*x + d)*x + h[1][c]);
+            }
+
+            ++nr_output;
+        }
+
+        t -= 1.0;
+    }
+
+    resampler->position = t;
+
+    return nr_output;
+}
+
@@ -0,0 +1,141 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "retrogauntlet.h"
+#include "audioring.h"
+
+bool create_audio_ring(struct audio_ring *ring, const size_t nr_bytes) {
+    if (!ring || nr_bytes == 0 || nr_bytes > ((size_t)1 << 29)) {
+        fprintf(ERROR_FILE, "create_audio_ring: Invalid ring or size!\n");
+        return false;
+    }
+
+    memset(ring, 0, sizeof(struct audio_ring));
+
+    //Round up to a power of two such that positions can be masked.
+    ring->nr_bytes = 1;
+    while (ring->nr_bytes < nr_bytes) ring->nr_bytes <<= 1;
+
+    if (!(ring->data = (uint8_t *)calloc(ring->nr_bytes, 1))) {
+        fprintf(ERROR_FILE, "create_audio_ring: Unable to allocate %zu bytes!\n", ring->nr_bytes);
+        return false;
+    }
+
+    return true;
+}
+
+bool free_audio_ring(struct audio_ring *ring) {
+    if (!ring) {
+        fprintf(ERROR_FILE, "free_audio_ring: Invalid ring!\n");
+        return false;
+    }
+
+    if (ring->data) free(ring->data);
+
+    memset(ring, 0, sizeof(struct audio_ring));
+
+    return true;
+}
+
+//Number of bytes that can be read, safe to call from any thread.
+size_t audio_ring_available(struct audio_ring *ring) {
+    if (!ring || !ring->data) return 0;
+
+    const size_t nr_available = (size_t)(SDL_AtomicGet(&ring->write_position) - SDL_AtomicGet(&ring->read_position)) & (2*ring->nr_bytes - 1);
+
+    SDL_MemoryBarrierAcquire();
+
+    return nr_available;
+}
+
+//Called by the producer only.
+size_t audio_ring_write(struct audio_ring *ring, const void *data, const size_t nr_bytes) {
+    if (!ring || !ring->data || !data) return 0;
+
+    const int write_position = SDL_AtomicGet(&ring->write_position);
+    const size_t nr_free = ring->nr_bytes - ((size_t)(write_position - SDL_AtomicGet(&ring->read_position)) & (2*ring->nr_bytes - 1));
+    const size_t nr_write = min(nr_bytes, nr_free);
+    const size_t start = (size_t)write_position & (ring->nr_bytes - 1);
+    const size_t first_write = min(nr_write, ring->nr_bytes - start);
+
+    //SDL_AtomicSet() and SDL_AtomicGet() do not order other memory accesses, so use explicit barriers.
+    SDL_MemoryBarrierAcquire();
+    memcpy(ring->data + start, data, first_write);
+    memcpy(ring->data, (const uint8_t *)data + first_write, nr_write - first_write);
+
+    if (nr_write < nr_bytes) SDL_AtomicAdd(&ring->nr_overflows, 1);
+
+    //Publish the data only after it has been copied.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->write_position, (int)(((size_t)write_position + nr_write) & (2*ring->nr_bytes - 1)));
+
+    return nr_write;
+}
+
+//Called by the consumer only, fills the remainder of the output with silence.
+size_t audio_ring_read(struct audio_ring *ring, void *data, const size_t nr_bytes) {
+    if (!ring || !ring->data || !data) return 0;
+
+    const int read_position = SDL_AtomicGet(&ring->read_position);
+    const size_t nr_available = (size_t)(SDL_AtomicGet(&ring->write_position) - read_position) & (2*ring->nr_bytes - 1);
+    const size_t nr_read = min(nr_bytes, nr_available);
+    const size_t start = (size_t)read_position & (ring->nr_bytes - 1);
+    const size_t first_read = min(nr_read, ring->nr_bytes - start);
+
+    SDL_MemoryBarrierAcquire();
+    memcpy(data, ring->data + start, first_read);
+    memcpy((uint8_t *)data + first_read, ring->data, nr_read - first_read);
+    memset((uint8_t *)data + nr_read, 0, nr_bytes - nr_read);
+
+    if (nr_read < nr_bytes) SDL_AtomicAdd(&ring->nr_underruns, 1);
+
+    //Release the space only after it has been copied.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->read_position, (int)(((size_t)read_position + nr_read) & (2*ring->nr_bytes - 1)));
+
+    return nr_read;
+}
+
+//Called by the consumer only, gives access to the data that can be read without wrapping around.
+size_t audio_ring_peek(struct audio_ring *ring, const uint8_t **data) {
+    if (!ring || !ring->data || !data) return 0;
+
+    const int read_position = SDL_AtomicGet(&ring->read_position);
+    const size_t nr_available = (size_t)(SDL_AtomicGet(&ring->write_position) - read_position) & (2*ring->nr_bytes - 1);
+    const size_t start = (size_t)read_position & (ring->nr_bytes - 1);
+
+    SDL_MemoryBarrierAcquire();
+    *data = ring->data + start;
+
+    return min(nr_available, ring->nr_bytes - start);
+}
+
+//Called by the consumer only, releases data obtained from audio_ring_peek().
+void audio_ring_skip(struct audio_ring *ring, const size_t nr_bytes) {
+    if (!ring || !ring->data) return;
+
+    const int read_position = SDL_AtomicGet(&ring->read_position);
+    const size_t nr_available = (size_t)(SDL_AtomicGet(&ring->write_position) - read_position) & (2*ring->nr_bytes - 1);
+
+    //Release the space only after the peeked data has been used.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->read_position, (int)(((size_t)read_position + min(nr_bytes, nr_available)) & (2*ring->nr_bytes - 1)));
+}
+
+//Discard all queued data, only call when the consumer is not running.
+void audio_ring_clear(struct audio_ring *ring) {
+    if (!ring) return;
+
+    SDL_AtomicSet(&ring->read_position, SDL_AtomicGet(&ring->write_position));
+}
+
@@ -10,10 +10,12 @@ You should have received a copy of the GNU General Public License along with Ret
 */
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "stringextra.h"
 #include "files.h"
 #include "core.h"
+#include "snapshotsimd.h"
 
 //For load_core_from_file.
 #ifdef _WIN32
@@ -38,6 +40,14 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #define NR_CORE_OPTION_LINE 4096
 
+//Snapshots are compared in chunks that fit in the L2 cache, consisting of pages that are skipped when unchanged.
+#define SNAPSHOT_CHUNK_SIZE (256*1024)
+#define SNAPSHOT_PAGE_SIZE 4096
+#define SNAPSHOT_MAX_THREADS 8
+
+//Switch to a candidate list once a memory search has narrowed down to this many offsets.
+#define SNAPSHOT_MAX_CANDIDATES 65536
+
 bool load_core_from_file(struct retro_core *core,
                          const char *core_file, const char *rom_file, const char *options_file,
                          retro_environment_t setup_function,
@@ -351,6 +361,9 @@ bool free_core(struct retro_core *core) {
     //Core was already freed.
     if (!core->dynamic_library) return false;
     
+    //Snapshot workers may still be reading core memory.
+    core_wait_for_snapshots(core);
+    
     core->retro_unload_game();
     core->retro_deinit();
 #ifdef _WIN32
@@ -361,6 +374,7 @@ bool free_core(struct retro_core *core) {
     free_core_variables(core);
     free_core_memory_maps(core);
     free_core_snapshots(core);
+    if (core->snapshot_pool.mutex) free_worker_pool(&core->snapshot_pool);
     if (core->full_path) free(core->full_path);
     if (core->rom_data) free(core->rom_data);
 
@@ -426,6 +440,8 @@ bool free_core_snapshots(struct retro_core *core) {
         return false;
     }
     
+    core_wait_for_snapshots(core);
+
     if (core->snapshot_data) {
         for (size_t i = 0; i < core->nr_snapshots; ++i) {
             if (core->snapshot_data[i]) free(core->snapshot_data[i]);
@@ -443,11 +459,21 @@ bool free_core_snapshots(struct retro_core *core) {
     }
 
     if (core->nr_snapshot_data) free(core->nr_snapshot_data);
+    if (core->snapshot_sources) free((void *)core->snapshot_sources);
+    if (core->snapshot_chunks) free(core->snapshot_chunks);
+    if (core->snapshot_candidates) free(core->snapshot_candidates);
 
     core->snapshot_data = NULL;
     core->snapshot_mask = NULL;
     core->nr_snapshot_data = NULL;
     core->nr_snapshots = 0;
+    core->snapshot_sources = NULL;
+    core->snapshot_chunks = NULL;
+    core->nr_snapshot_chunks = 0;
+    core->max_snapshot_chunks = 0;
+    core->snapshot_candidates = NULL;
+    core->nr_snapshot_candidates = 0;
+    core->snapshot_candidates_active = false;
     
     return true;
 }
@@ -768,13 +794,274 @@ bool free_core_snapshots(struct retro_core *core) {
     done = true; \
 } while (false);
 
-//Helper function for core_task_and_compare_snapshots().
-void update_snapshot(struct retro_core *core, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value, const size_t i_snapshot, const size_t nr_data, const void *data) {
-    if (!core) return;
-    if (i_snapshot >= core->nr_snapshots) return;
+//Scalar masking of a snapshot, also used as reference for the SIMD kernels in snapshotsimd.c.
+void update_snapshot_mask_scalar(uint8_t *m_p, const uint8_t *o_p, const uint8_t *n_p, const size_t nr_data, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value, const size_t i_snapshot) {
+    //Perform common masking operations more efficiently.
+    bool done = false;
+    
+    //Any conditions we can handle in an optimized way?
+    switch (size_value) {
+        case MEMCON_VAR_8BIT:
+            UPDATE_SNAPSHOT_MASK_CONDITION(uint8_t);
+            break;
+        case MEMCON_VAR_16BIT:
+            UPDATE_SNAPSHOT_MASK_CONDITION(uint16_t);
+            break;
+        case MEMCON_VAR_32BIT:
+            UPDATE_SNAPSHOT_MASK_CONDITION(uint32_t);
+            break;
+        case MEMCON_VAR_64BIT:
+            UPDATE_SNAPSHOT_MASK_CONDITION(uint64_t);
+            break;
+        default:
+            fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unknown data type!\n");
+            break;
+    };
+    
+    //Generic condition combination.
+    if (!done) {
+        switch (size_value) {
+            case MEMCON_VAR_8BIT:
+                UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint8_t);
+                break;
+            case MEMCON_VAR_16BIT:
+                UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint16_t);
+                break;
+            case MEMCON_VAR_32BIT:
+                UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint32_t);
+                break;
+            case MEMCON_VAR_64BIT:
+                UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint64_t);
+                break;
+            default:
+                fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unknown data type!\n");
+                break;
+        }
+    }
+}
+
+//Number of byte offsets at which a value of the given size is compared, matching the scalar loops.
+size_t snapshot_nr_offsets(const unsigned mask_condition, const unsigned data_condition, const unsigned size_value, const size_t nr_data) {
+    const size_t nr_bytes = (size_t)1 << size_value;
+
+    if (mask_condition == MASK_IF_MASK_ALWAYS && data_condition == MASK_IF_DATA_ALWAYS) return nr_data;
+    if (size_value > MEMCON_VAR_64BIT || nr_data < nr_bytes) return 0;
+    
+    return nr_data - nr_bytes + 1;
+}
+
+//Number of bytes at the start of each chunk that are also read when comparing the previous chunk.
+size_t snapshot_nr_overlap(const struct retro_core *core) {
+    if (core->compare_mask_condition == MASK_IF_MASK_NEVER || core->compare_data_condition == MASK_IF_DATA_NEVER || core->compare_mask_action == MASK_THEN_NOP) return 0;
+    if (core->compare_size_value > MEMCON_VAR_64BIT) return 0;
+
+    return ((size_t)1 << core->compare_size_value) - 1;
+}
+
+//Update the masks of offsets [begin, end) of a snapshot with the given data condition.
+void update_snapshot_mask_range(const struct retro_core *core, const size_t i_snapshot, const size_t begin, const size_t end, const unsigned data_condition) {
+    const snapshot_kernel_t kernel = snapshot_simd_kernel(core->cpu_features);
+    const uint8_t *n_p = core->snapshot_sources[i_snapshot] + begin;
+    const uint8_t *o_p = core->snapshot_data[i_snapshot] + begin;
+    uint8_t *m_p = core->snapshot_mask[i_snapshot] + begin;
+
+    if (begin >= end) return;
+    
+    //Logging is only supported by the scalar path.
+    if (kernel && core->compare_mask_action != MASK_THEN_LOG) {
+        kernel(m_p, o_p, n_p, end - begin, core->compare_mask_condition, data_condition, core->compare_mask_action, core->compare_size_value, core->compare_const_value);
+    }
+    else {
+        const size_t nr_data = (core->compare_mask_condition == MASK_IF_MASK_ALWAYS && data_condition == MASK_IF_DATA_ALWAYS ? end - begin : end - begin + ((size_t)1 << core->compare_size_value) - 1);
+
+        update_snapshot_mask_scalar(m_p, o_p, n_p, nr_data, core->compare_mask_condition, data_condition, core->compare_mask_action, core->compare_size_value, core->compare_const_value, i_snapshot);
+    }
+}
+
+//Compare and copy a single chunk of a snapshot page by page, run by the snapshot worker pool.
+void snapshot_chunk_job(void *data, const size_t i_chunk) {
+    const struct retro_core *core = (const struct retro_core *)data;
+    struct retro_core_snapshot_chunk *chunk = &core->snapshot_chunks[i_chunk];
+    const size_t nr_data = core->nr_snapshot_data[chunk->snapshot];
+    const size_t nr_overlap = snapshot_nr_overlap(core);
+    const uint8_t *n_p = core->snapshot_sources[chunk->snapshot];
+    uint8_t *o_p = core->snapshot_data[chunk->snapshot];
+    uint8_t *m_p = core->snapshot_mask[chunk->snapshot];
+    const bool update_masks = (core->compare_mask_condition != MASK_IF_MASK_NEVER && core->compare_data_condition != MASK_IF_DATA_NEVER && core->compare_mask_action != MASK_THEN_NOP);
+    const size_t nr_offsets = (update_masks ? snapshot_nr_offsets(core->compare_mask_condition, core->compare_data_condition, core->compare_size_value, nr_data) : 0);
+    
+    if (update_masks && nr_offsets == 0) {
+        fprintf(MEM_FILE, "Snapshot %zu is too small for the requested data type!\n", chunk->snapshot);
+    }
+
+    //Logged offsets are relative to the page, so use a single page when logging.
+    const size_t page_size = (core->compare_mask_action == MASK_THEN_LOG ? chunk->end - chunk->begin : SNAPSHOT_PAGE_SIZE);
+
+    chunk->nr_dirty_pages = 0;
+    
+    for (size_t page = chunk->begin; page < chunk->end; page += page_size) {
+        const size_t page_end = (chunk->end - page < page_size ? chunk->end : page + page_size);
+        const size_t read_end = (nr_data - page_end < nr_overlap ? nr_data : page_end + nr_overlap);
+        const bool dirty = (memcmp(n_p + page, o_p + page, read_end - page) != 0);
+        unsigned data_condition = core->compare_data_condition;
+        
+        //Unchanged memory never satisfies changed/greater/less conditions and always satisfies the equal condition.
+        if (!dirty && core->compare_mask_action != MASK_THEN_LOG) {
+            if (data_condition == MASK_IF_DATA_CHANGED || data_condition == MASK_IF_DATA_GREATER_PREV || data_condition == MASK_IF_DATA_LESS_PREV) data_condition = MASK_IF_DATA_NEVER;
+            else if (data_condition == MASK_IF_DATA_EQUAL_PREV) data_condition = MASK_IF_DATA_ALWAYS;
+        }
+
+        //Update masks if needed.
+        if (update_masks && data_condition != MASK_IF_DATA_NEVER) {
+            update_snapshot_mask_range(core, chunk->snapshot, page, (page_end < nr_offsets ? page_end : nr_offsets), data_condition);
+        }
+        
+        //Update snapshot, except for the first bytes of the chunk that the previous chunk may still be reading.
+        if (dirty) {
+            const size_t copy_begin = (page == chunk->begin ? page + nr_overlap : page);
+
+            if (copy_begin < page_end) memcpy(o_p + copy_begin, n_p + copy_begin, page_end - copy_begin);
+            chunk->nr_dirty_pages++;
+        }
+    }
+
+    //Count survivors to decide whether to switch to a candidate list.
+    size_t nr_candidates = 0;
+
+    for (size_t i = chunk->begin; i < chunk->end; ++i) {
+        nr_candidates += (m_p[i] == 1 ? 1 : 0);
+    }
+
+    chunk->nr_candidates = nr_candidates;
+}
+
+//Retrieve the core memory belonging to a snapshot index.
+const uint8_t *get_snapshot_memory(const struct retro_core *core, const size_t i_snapshot, size_t *nr_data) {
+    const unsigned ids[4] = {RETRO_MEMORY_SAVE_RAM, RETRO_MEMORY_RTC, RETRO_MEMORY_SYSTEM_RAM, RETRO_MEMORY_VIDEO_RAM};
+
+    if (i_snapshot < 4) {
+        *nr_data = core->retro_get_memory_size(ids[i_snapshot]);
+        return (const uint8_t *)core->retro_get_memory_data(ids[i_snapshot]);
+    }
+
+    if (i_snapshot - 4 < core->mmap.num_descriptors) {
+        *nr_data = core->mmap.descriptors[i_snapshot - 4].len;
+        return (const uint8_t *)core->mmap.descriptors[i_snapshot - 4].ptr;
+    }
+
+    *nr_data = 0;
+    return NULL;
+}
+
+//Build the candidate list from all mask values equal to one after a full comparison.
+bool create_snapshot_candidates(struct retro_core *core, const size_t nr_candidates) {
+    struct retro_core_snapshot_candidate *candidates = (struct retro_core_snapshot_candidate *)realloc(core->snapshot_candidates, (nr_candidates > 0 ? nr_candidates : 1)*sizeof(struct retro_core_snapshot_candidate));
+    size_t j = 0;
+
+    if (!candidates) {
+        fprintf(ERROR_FILE, "create_snapshot_candidates: Unable to allocate %zu candidates!\n", nr_candidates);
+        return false;
+    }
+
+    core->snapshot_candidates = candidates;
+
+    for (size_t i = 0; i < core->nr_snapshot_chunks; ++i) {
+        const struct retro_core_snapshot_chunk *chunk = &core->snapshot_chunks[i];
+        const size_t nr_data = core->nr_snapshot_data[chunk->snapshot];
+        const uint8_t *o_p = core->snapshot_data[chunk->snapshot];
+        const uint8_t *m_p = core->snapshot_mask[chunk->snapshot];
+
+        if (chunk->nr_candidates == 0) continue;
+
+        for (size_t k = chunk->begin; k < chunk->end && j < nr_candidates; ++k) {
+            if (m_p[k] != 1) continue;
+
+            candidates[j].snapshot = chunk->snapshot;
+            candidates[j].offset = k;
+            candidates[j].value = 0;
+            memcpy(&candidates[j].value, o_p + k, (nr_data - k < sizeof(uint64_t) ? nr_data - k : sizeof(uint64_t)));
+            ++j;
+        }
+    }
+
+    core->nr_snapshot_candidates = j;
+    core->snapshot_candidates_active = true;
+
+    fprintf(MEM_FILE, "Narrowed memory search down to %zu candidates, only comparing those from now on.\n", j);
+
+    return true;
+}
+
+//Return to full comparisons: candidate offsets get their data of the last comparison, all other offsets keep the data of the last full comparison.
+void leave_snapshot_candidates(struct retro_core *core) {
+    if (!core->snapshot_candidates_active) return;
+
+    //Only restore the byte at each candidate offset, as the bytes following it may belong to offsets that are not candidates.
+    for (size_t i = 0; i < core->nr_snapshot_candidates; ++i) {
+        const struct retro_core_snapshot_candidate *c = &core->snapshot_candidates[i];
+
+        memcpy(core->snapshot_data[c->snapshot] + c->offset, &c->value, 1);
+    }
+
+    core->nr_snapshot_candidates = 0;
+    core->snapshot_candidates_active = false;
+
+    fprintf(MEM_FILE, "Returning to full memory comparisons.\n");
+}
+
+//Compare only the candidates of a narrowed search, costing O(candidates). Returns false if a full comparison is required instead.
+bool update_snapshot_candidates(struct retro_core *core, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value) {
+    const bool update_masks = (mask_condition != MASK_IF_MASK_NEVER && data_condition != MASK_IF_DATA_NEVER && mask_action != MASK_THEN_NOP);
+    
+    //Conditions that can select offsets with mask values other than one need all data.
+    if (update_masks && mask_condition != MASK_IF_MASK_ONE) return false;
+    if (size_value > MEMCON_VAR_64BIT) return false;
+    if (core->nr_snapshots != 4 + core->mmap.num_descriptors) return false;
+
+    //Memory regions should not have moved or changed size.
+    for (size_t i = 0; i < core->nr_snapshots; ++i) {
+        size_t nr_data = 0;
+        
+        core->snapshot_sources[i] = get_snapshot_memory(core, i, &nr_data);
+        if (core->nr_snapshot_data[i] > 0 && (nr_data != core->nr_snapshot_data[i] || !core->snapshot_sources[i])) return false;
+    }
+
+    const size_t nr_bytes = (size_t)1 << size_value;
+    const uint64_t value_mask = (nr_bytes < sizeof(uint64_t) ? ((uint64_t)1 << (8*nr_bytes)) - 1 : ~(uint64_t)0);
+    size_t j = 0;
+
+    for (size_t i = 0; i < core->nr_snapshot_candidates; ++i) {
+        struct retro_core_snapshot_candidate c = core->snapshot_candidates[i];
+        const size_t nr_data = core->nr_snapshot_data[c.snapshot];
+        uint8_t *m_p = core->snapshot_mask[c.snapshot];
+        uint64_t n = 0;
+
+        memcpy(&n, core->snapshot_sources[c.snapshot] + c.offset, (nr_data - c.offset < sizeof(uint64_t) ? nr_data - c.offset : sizeof(uint64_t)));
+
+        //Offsets whose value would extend past the end are skipped, as in the full comparison.
+        if (update_masks && c.offset + nr_bytes <= nr_data && snapshot_data_condition(data_condition, n & value_mask, c.value & value_mask, const_value)) {
+            if (mask_action == MASK_THEN_LOG) fprintf(MEM_FILE, "%08zx %08zx %02x %08zx %08zx\n", c.snapshot, c.offset, m_p[c.offset], c.value & value_mask, n & value_mask);
+            else m_p[c.offset] = snapshot_mask_action(mask_action, m_p[c.offset]);
+        }
+
+        c.value = n;
+        if (m_p[c.offset] == 1) core->snapshot_candidates[j++] = c;
+    }
+
+    core->nr_snapshot_candidates = j;
+
+    return true;
+}
+
+//Helper function for core_start_snapshot_comparison(): allocate snapshot storage and split it into chunks.
+bool add_snapshot_chunks(struct retro_core *core, const size_t i_snapshot, const size_t nr_data, const void *data) {
+    if (i_snapshot >= core->nr_snapshots) return false;
+
+    core->snapshot_sources[i_snapshot] = NULL;
+
     if (nr_data == 0 || !data) {
         fprintf(MEM_FILE, "Core provides no data for snapshot %zu!\n", i_snapshot);
-        return;
+        return true;
     }
     
     if (nr_data != core->nr_snapshot_data[i_snapshot] ||
@@ -789,78 +1076,61 @@ void update_snapshot(struct retro_core *core, const unsigned mask_condition, con
         
         if (!core->snapshot_data[i_snapshot] || !core->snapshot_mask[i_snapshot]) {
             fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unable to allocate snapshot data for %zu bytes!\n", nr_data);
-            return;
+            core->nr_snapshot_data[i_snapshot] = 0;
+            return false;
         }
 
         memset(core->snapshot_mask[i_snapshot], 0, nr_data);
     }
-    
-    //Update masks if needed.
-    if (mask_condition != MASK_IF_MASK_NEVER && data_condition != MASK_IF_DATA_NEVER && mask_action != MASK_THEN_NOP) {
-        const uint8_t *n_p = (const uint8_t *)data;
-        const uint8_t *o_p = core->snapshot_data[i_snapshot];
-        uint8_t *m_p = core->snapshot_mask[i_snapshot];
-        
-        //Perform common masking operations more efficiently.
-        bool done = false;
-        
-        //Any conditions we can handle in an optimized way?
-        switch (size_value) {
-            case MEMCON_VAR_8BIT:
-                UPDATE_SNAPSHOT_MASK_CONDITION(uint8_t);
-                break;
-            case MEMCON_VAR_16BIT:
-                UPDATE_SNAPSHOT_MASK_CONDITION(uint16_t);
-                break;
-            case MEMCON_VAR_32BIT:
-                UPDATE_SNAPSHOT_MASK_CONDITION(uint32_t);
-                break;
-            case MEMCON_VAR_64BIT:
-                UPDATE_SNAPSHOT_MASK_CONDITION(uint64_t);
-                break;
-            default:
-                fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unknown data type!\n");
-                break;
-        };
-        
-        //Generic condition combination.
-        if (!done) {
-            switch (size_value) {
-                case MEMCON_VAR_8BIT:
-                    UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint8_t);
-                    break;
-                case MEMCON_VAR_16BIT:
-                    UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint16_t);
-                    break;
-                case MEMCON_VAR_32BIT:
-                    UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint32_t);
-                    break;
-                case MEMCON_VAR_64BIT:
-                    UPDATE_SNAPSHOT_MASK_CONDITION_GENERIC(uint64_t);
-                    break;
-                default:
-                    fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unknown data type!\n");
-                    break;
-            }
+
+    //Logged offsets are relative to the chunk, so do not split snapshots when logging.
+    const size_t chunk_size = (core->compare_mask_action == MASK_THEN_LOG ? nr_data : SNAPSHOT_CHUNK_SIZE);
+    const size_t nr_chunks = (nr_data + chunk_size - 1)/chunk_size;
+
+    if (core->nr_snapshot_chunks + nr_chunks > core->max_snapshot_chunks) {
+        const size_t max_chunks = 2*(core->nr_snapshot_chunks + nr_chunks);
+        struct retro_core_snapshot_chunk *chunks = (struct retro_core_snapshot_chunk *)realloc(core->snapshot_chunks, max_chunks*sizeof(struct retro_core_snapshot_chunk));
+
+        if (!chunks) {
+            fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unable to allocate %zu snapshot chunks!\n", max_chunks);
+            return false;
         }
+
+        core->snapshot_chunks = chunks;
+        core->max_snapshot_chunks = max_chunks;
     }
 
-    //Update snapshot.
-    memcpy(core->snapshot_data[i_snapshot], data, nr_data);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        struct retro_core_snapshot_chunk *chunk = &core->snapshot_chunks[core->nr_snapshot_chunks++];
+
+        chunk->snapshot = i_snapshot;
+        chunk->nr_candidates = 0;
+        chunk->nr_dirty_pages = 0;
+        chunk->begin = i*chunk_size;
+        chunk->end = (nr_data - chunk->begin < chunk_size ? nr_data : chunk->begin + chunk_size);
+    }
+
+    core->snapshot_sources[i_snapshot] = (const uint8_t *)data;
+
+    return true;
 }
 
-bool core_take_and_compare_snapshots(struct retro_core *core, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value) {
+bool core_start_snapshot_comparison(struct retro_core *core, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value) {
     if (!core) {
         fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Invalid core!\n");
         return false;
     }
     
+    //Finish any previous comparison before touching the snapshots.
+    core_wait_for_snapshots(core);
+
     //Allocate data if it is not there.
     const size_t nr_snapshots = 4 + core->mmap.num_descriptors;
 
     fprintf(MEM_FILE, "Updating %zu snapshots with masks %u, %u, %u...\n", nr_snapshots, mask_condition, data_condition, mask_action);
 
     if (core->nr_snapshots != nr_snapshots) {
+        leave_snapshot_candidates(core);
         free_core_snapshots(core);
         
         fprintf(CORE_FILE, "Allocating %zu snapshot arrays...\n", nr_snapshots);
@@ -869,27 +1139,223 @@ bool core_take_and_compare_snapshots(struct retro_core *core, const unsigned mas
         core->nr_snapshot_data = (size_t *)calloc(nr_snapshots, sizeof(size_t));
         core->snapshot_data = (uint8_t **)calloc(nr_snapshots, sizeof(void *));
         core->snapshot_mask = (uint8_t **)calloc(nr_snapshots, sizeof(void *));
+        core->snapshot_sources = (const uint8_t **)calloc(nr_snapshots, sizeof(void *));
 
-        if (!core->nr_snapshot_data || !core->snapshot_data || !core->snapshot_mask) {
+        if (!core->nr_snapshot_data || !core->snapshot_data || !core->snapshot_mask || !core->snapshot_sources) {
             fprintf(ERROR_FILE, "core_take_and_compare_snapshots: Unable to allocate snapshot arrays!\n");
             return false;
         }
     }
 
-    //Retrieve retro_get_memory_* snapshots.
-    update_snapshot(core, mask_condition, data_condition, mask_action, size_value, const_value, 0, core->retro_get_memory_size(RETRO_MEMORY_SAVE_RAM), core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM));
-    update_snapshot(core, mask_condition, data_condition, mask_action, size_value, const_value, 1, core->retro_get_memory_size(RETRO_MEMORY_RTC), core->retro_get_memory_data(RETRO_MEMORY_RTC));
-    update_snapshot(core, mask_condition, data_condition, mask_action, size_value, const_value, 2, core->retro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM), core->retro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM));
-    update_snapshot(core, mask_condition, data_condition, mask_action, size_value, const_value, 3, core->retro_get_memory_size(RETRO_MEMORY_VIDEO_RAM), core->retro_get_memory_data(RETRO_MEMORY_VIDEO_RAM));
+    core->compare_mask_condition = mask_condition;
+    core->compare_data_condition = data_condition;
+    core->compare_mask_action = mask_action;
+    core->compare_size_value = size_value;
+    core->compare_const_value = const_value;
+    core->nr_snapshot_chunks = 0;
+
+    //Narrowed searches only need to look at the remaining candidates.
+    if (core->snapshot_candidates_active) {
+        if (update_snapshot_candidates(core, mask_condition, data_condition, mask_action, size_value, const_value)) return true;
+        
+        leave_snapshot_candidates(core);
+    }
+
+    //Retrieve retro_get_memory_* and memory mapped snapshots.
+    for (size_t i = 0; i < nr_snapshots; ++i) {
+        size_t nr_data = 0;
+        const uint8_t *data = get_snapshot_memory(core, i, &nr_data);
+
+        add_snapshot_chunks(core, i, nr_data, data);
+    }
+
+    core->snapshot_pending = true;
+
+    //Create worker threads the first time there is enough work for them.
+    if (!core->snapshot_pool.mutex && core->nr_snapshot_chunks > 1 && SDL_GetCPUCount() > 1) {
+        const size_t nr_threads = (size_t)SDL_GetCPUCount() - 1;
+
+        create_worker_pool(&core->snapshot_pool, (nr_threads < SNAPSHOT_MAX_THREADS ? nr_threads : SNAPSHOT_MAX_THREADS));
+    }
+    
+    //Log output should not be interleaved, so run those on the calling thread.
+    if (mask_action == MASK_THEN_LOG || !core->snapshot_pool.mutex) {
+        for (size_t i = 0; i < core->nr_snapshot_chunks; ++i) {
+            snapshot_chunk_job(core, i);
+        }
+    }
+    else {
+        worker_pool_start(&core->snapshot_pool, snapshot_chunk_job, core, core->nr_snapshot_chunks);
+    }
+
+    return true;
+}
+
+bool core_wait_for_snapshots(struct retro_core *core) {
+    if (!core) {
+        fprintf(ERROR_FILE, "core_wait_for_snapshots: Invalid core!\n");
+        return false;
+    }
+
+    if (!core->snapshot_pending) return true;
+
+    if (core->snapshot_pool.mutex) worker_pool_wait(&core->snapshot_pool);
+
+    //Copy the start of each chunk now that no comparison reads it anymore.
+    const size_t nr_overlap = snapshot_nr_overlap(core);
+
+    for (size_t i = 0; i < core->nr_snapshot_chunks && nr_overlap > 0; ++i) {
+        const struct retro_core_snapshot_chunk *chunk = &core->snapshot_chunks[i];
+        const size_t nr_copy = (chunk->end - chunk->begin < nr_overlap ? chunk->end - chunk->begin : nr_overlap);
+
+        memcpy(core->snapshot_data[chunk->snapshot] + chunk->begin, core->snapshot_sources[chunk->snapshot] + chunk->begin, nr_copy);
+    }
+
+    core->snapshot_pending = false;
 
-    //Retrieve memory mapped snapshots.
-    for (size_t i = 0; i < core->mmap.num_descriptors; i++) {
-        update_snapshot(core, mask_condition, data_condition, mask_action, size_value, const_value, 4 + i, core->mmap.descriptors[i].len, core->mmap.descriptors[i].ptr);
+    //Switch to a candidate list once only few offsets remain.
+    size_t nr_candidates = 0;
+    size_t nr_dirty_pages = 0;
+    size_t nr_pages = 0;
+
+    for (size_t i = 0; i < core->nr_snapshot_chunks; ++i) {
+        const struct retro_core_snapshot_chunk *chunk = &core->snapshot_chunks[i];
+
+        nr_candidates += chunk->nr_candidates;
+        nr_dirty_pages += chunk->nr_dirty_pages;
+        nr_pages += (chunk->end - chunk->begin + SNAPSHOT_PAGE_SIZE - 1)/SNAPSHOT_PAGE_SIZE;
     }
+    
+    fprintf(MEM_FILE, "Compared snapshots: %zu of %zu pages changed, %zu offsets with mask one.\n", nr_dirty_pages, nr_pages, nr_candidates);
+    
+    if (nr_candidates <= SNAPSHOT_MAX_CANDIDATES && core->nr_snapshot_chunks > 0) create_snapshot_candidates(core, nr_candidates);
 
     return true;
 }
 
+bool core_take_and_compare_snapshots(struct retro_core *core, const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, const unsigned size_value, const uint64_t const_value) {
+    if (!core_start_snapshot_comparison(core, mask_condition, data_condition, mask_action, size_value, const_value)) return false;
+
+    return core_wait_for_snapshots(core);
+}
+
+//Compare the SIMD snapshot kernels against the scalar path for all masking combinations on random data.
+bool core_verify_snapshot_kernels(const uint64_t cpu_features) {
+    const uint64_t kernel_features[2] = {RETRO_SIMD_SSE2, RETRO_SIMD_AVX2};
+    const unsigned mask_conditions[3] = {MASK_IF_MASK_ALWAYS, MASK_IF_MASK_ZERO, MASK_IF_MASK_ONE};
+    const unsigned data_conditions[8] = {MASK_IF_DATA_ALWAYS, MASK_IF_DATA_CHANGED, MASK_IF_DATA_EQUAL_PREV, MASK_IF_DATA_GREATER_PREV, MASK_IF_DATA_LESS_PREV, MASK_IF_DATA_EQUAL_CONST, MASK_IF_DATA_GREATER_CONST, MASK_IF_DATA_LESS_CONST};
+    const size_t nr_datas[3] = {1031, 37, 3};
+    const size_t nr_data_max = 1031;
+    const size_t nr_scan = 16*1024*1024;
+    uint8_t *o_p = (uint8_t *)malloc(nr_scan);
+    uint8_t *n_p = (uint8_t *)malloc(nr_scan);
+    uint8_t *m_p = (uint8_t *)malloc(nr_scan);
+    uint8_t *m_start = (uint8_t *)malloc(nr_scan);
+    uint8_t *m_scalar = (uint8_t *)malloc(nr_data_max);
+    uint8_t *m_kernel = (uint8_t *)malloc(nr_data_max);
+    uint32_t rng = 0x12345678;
+    size_t nr_checks = 0;
+    size_t nr_failures = 0;
+
+    if (!o_p || !n_p || !m_p || !m_start || !m_scalar || !m_kernel) {
+        fprintf(ERROR_FILE, "core_verify_snapshot_kernels: Unable to allocate buffers!\n");
+        if (o_p) free(o_p);
+        if (n_p) free(n_p);
+        if (m_p) free(m_p);
+        if (m_start) free(m_start);
+        if (m_scalar) free(m_scalar);
+        if (m_kernel) free(m_kernel);
+        return false;
+    }
+
+    //Create data that changes in some bytes and masks containing 0, 1, and other values.
+    for (size_t i = 0; i < nr_scan; ++i) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        o_p[i] = (uint8_t)(rng & 0x7);
+        n_p[i] = ((rng >> 8) & 0x3) == 0 ? (uint8_t)(rng >> 16) : o_p[i];
+        m_p[i] = ((rng >> 24) & 0x3) == 3 ? 0xff : (uint8_t)((rng >> 24) & 0x3);
+    }
+
+    memcpy(m_start, m_p, nr_scan);
+
+    for (size_t k = 0; k < 2; ++k) {
+        const snapshot_kernel_t kernel = snapshot_simd_kernel(kernel_features[k]);
+
+        if (!(cpu_features & kernel_features[k]) || !kernel) continue;
+
+        for (size_t i_size = MEMCON_VAR_8BIT; i_size <= MEMCON_VAR_64BIT; ++i_size) {
+            uint64_t const_values[3] = {0, 0, 0x123456789aLL};
+
+            memcpy(&const_values[1], n_p + 17, (size_t)1 << i_size);
+
+            for (size_t i_data = 0; i_data < 3; ++i_data) {
+                const size_t nr_data = nr_datas[i_data];
+
+                for (size_t i_mc = 0; i_mc < 3; ++i_mc) {
+                    for (size_t i_dc = 0; i_dc < 8; ++i_dc) {
+                        for (unsigned mask_action = MASK_THEN_SET_ZERO; mask_action <= MASK_THEN_SUB_ONE; ++mask_action) {
+                            for (size_t i_c = 0; i_c < 3; ++i_c) {
+                                const size_t nr_offsets = snapshot_nr_offsets(mask_conditions[i_mc], data_conditions[i_dc], (unsigned)i_size, nr_data);
+
+                                memcpy(m_scalar, m_p, nr_data);
+                                memcpy(m_kernel, m_p, nr_data);
+                                if (nr_offsets > 0) {
+                                    update_snapshot_mask_scalar(m_scalar, o_p, n_p, nr_data, mask_conditions[i_mc], data_conditions[i_dc], mask_action, (unsigned)i_size, const_values[i_c], 0);
+                                    kernel(m_kernel, o_p, n_p, nr_offsets, mask_conditions[i_mc], data_conditions[i_dc], mask_action, (unsigned)i_size, const_values[i_c]);
+                                }
+                                ++nr_checks;
+
+                                if (memcmp(m_scalar, m_kernel, nr_data) != 0) {
+                                    fprintf(ERROR_FILE, "core_verify_snapshot_kernels: Kernel %s differs from scalar for size %zu, mask %u, data %u, action %u, value %llx, %zu bytes!\n",
+                                            snapshot_simd_kernel_name(kernel_features[k]), i_size, mask_conditions[i_mc], data_conditions[i_dc], mask_action, (unsigned long long)const_values[i_c], nr_data);
+                                    ++nr_failures;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    fprintf(BENCH_FILE, "snapshot_kernel: %s\n", snapshot_simd_kernel_name(cpu_features));
+    fprintf(BENCH_FILE, "snapshot_kernel_checks: %zu\n", nr_checks);
+    fprintf(BENCH_FILE, "snapshot_kernel_failures: %zu\n", nr_failures);
+
+    //Time a typical search refinement step for both paths, starting from the same mask as the steps modify it.
+    for (size_t k = 0; k < 2; ++k) {
+        const snapshot_kernel_t kernel = (k == 0 ? NULL : snapshot_simd_kernel(cpu_features));
+        
+        if (k == 1 && !kernel) break;
+
+        memcpy(m_p, m_start, nr_scan);
+
+        const uint64_t start_ticks = SDL_GetPerformanceCounter();
+
+        for (size_t i_size = MEMCON_VAR_8BIT; i_size <= MEMCON_VAR_64BIT; ++i_size) {
+            const size_t nr_offsets = snapshot_nr_offsets(MASK_IF_MASK_ONE, MASK_IF_DATA_CHANGED, (unsigned)i_size, nr_scan);
+
+            if (kernel) kernel(m_p, o_p, n_p, nr_offsets, MASK_IF_MASK_ONE, MASK_IF_DATA_CHANGED, MASK_THEN_XOR_ONE, (unsigned)i_size, 0);
+            else update_snapshot_mask_scalar(m_p, o_p, n_p, nr_scan, MASK_IF_MASK_ONE, MASK_IF_DATA_CHANGED, MASK_THEN_XOR_ONE, (unsigned)i_size, 0, 0);
+        }
+
+        const double seconds = (double)(SDL_GetPerformanceCounter() - start_ticks)/(double)SDL_GetPerformanceFrequency();
+
+        fprintf(BENCH_FILE, "snapshot_scan_%s_mb_per_s: %.1f\n", (k == 0 ? "scalar" : snapshot_simd_kernel_name(cpu_features)), 4.0*(double)nr_scan/(1024.0*1024.0*seconds));
+    }
+
+    free(o_p);
+    free(n_p);
+    free(m_p);
+    free(m_start);
+    free(m_scalar);
+    free(m_kernel);
+
+    return (nr_failures == 0);
+}
+
 bool free_core_memory_maps(struct retro_core *core) {
     if (!core) {
         fprintf(ERROR_FILE, "free_core_memory_maps: Invalid core!\n");
@@ -943,6 +1409,9 @@ bool core_unserialize_from_file(struct retro_core *core, const char *file) {
         return false;
     }
 
+    //Snapshot workers may still be reading core memory.
+    core_wait_for_snapshots(core);
+
     FILE *f = fopen(file, "rb");
 
     if (!f) {
@@ -987,6 +1456,77 @@ bool core_unserialize_from_file(struct retro_core *core, const char *file) {
     return true;
 }
 
+bool create_core_state_pool(struct retro_core_state_pool *pool, struct retro_core *core, const size_t nr_states) {
+    if (!pool || !core || !core->retro_serialize_size || nr_states == 0) {
+        fprintf(ERROR_FILE, "create_core_state_pool: Invalid pool or core!\n");
+        return false;
+    }
+
+    memset(pool, 0, sizeof(struct retro_core_state_pool));
+
+    const size_t nr_bytes = core->retro_serialize_size();
+
+    if (nr_bytes == 0) {
+        fprintf(ERROR_FILE, "create_core_state_pool: Core does not support serialization!\n");
+        return false;
+    }
+
+    //Leave headroom for cores whose state grows during play.
+    pool->nr_state_bytes = nr_bytes + nr_bytes/4;
+    pool->nr_states = nr_states;
+    pool->data = (uint8_t *)malloc(pool->nr_states*pool->nr_state_bytes);
+
+    if (!pool->data) {
+        fprintf(ERROR_FILE, "create_core_state_pool: Unable to allocate %zu states of %zu bytes!\n", pool->nr_states, pool->nr_state_bytes);
+        memset(pool, 0, sizeof(struct retro_core_state_pool));
+        return false;
+    }
+
+    fprintf(CORE_FILE, "Allocated %zu core states of %zu bytes.\n", pool->nr_states, pool->nr_state_bytes);
+
+    return true;
+}
+
+bool free_core_state_pool(struct retro_core_state_pool *pool) {
+    if (!pool) {
+        fprintf(ERROR_FILE, "free_core_state_pool: Invalid pool!\n");
+        return false;
+    }
+
+    if (pool->data) free(pool->data);
+
+    memset(pool, 0, sizeof(struct retro_core_state_pool));
+
+    return true;
+}
+
+//Serialize the core into the next state of the pool and return it, or NULL on failure.
+const uint8_t *core_serialize_to_pool(struct retro_core_state_pool *pool, struct retro_core *core, size_t *nr_bytes_p) {
+    if (!pool || !pool->data || !core || !nr_bytes_p) {
+        fprintf(ERROR_FILE, "core_serialize_to_pool: Invalid pool or core!\n");
+        return NULL;
+    }
+
+    const size_t nr_bytes = core->retro_serialize_size();
+
+    if (nr_bytes == 0 || nr_bytes > pool->nr_state_bytes) {
+        fprintf(ERROR_FILE, "core_serialize_to_pool: State of %zu bytes does not fit in %zu bytes!\n", nr_bytes, pool->nr_state_bytes);
+        return NULL;
+    }
+
+    uint8_t *state = pool->data + pool->next_state*pool->nr_state_bytes;
+
+    if (!core->retro_serialize(state, nr_bytes)) {
+        fprintf(ERROR_FILE, "core_serialize_to_pool: Unable to serialize state!\n");
+        return NULL;
+    }
+
+    pool->next_state = (pool->next_state + 1) % pool->nr_states;
+    *nr_bytes_p = nr_bytes;
+
+    return state;
+}
+
 #define COND_GET_VALUE_TYPED(type) do { \
     if (c->offset <= nr_data - sizeof(type)) value = *(const type *)(data + c->offset); \
 } while (false);
@@ -1078,14 +1618,511 @@ bool core_check_conditions(const struct retro_core *core, struct retro_core_memo
     return false;
 }
 
-bool core_load_conditions_from_file(struct retro_core_memory_condition **conds_p, size_t *nr_conds_p, const char *file) {
-    if (!conds_p || !nr_conds_p || !file) {
-        fprintf(ERROR_FILE, "core_load_conditions_from_file: Invalid conditions or file!\n");
+//Specialized condition evaluation for each value size and comparison, used by condition plans.
+#define COND_EVALUATE_FUNCTION(name, type, test) \
+static bool name(const uint8_t *data, struct retro_core_memory_condition *c) { \
+    type v; \
+    memcpy(&v, data + c->offset, sizeof(type)); \
+    const uint64_t value = v; \
+    const bool triggered = (test); \
+    c->last_value = value; \
+    return triggered; \
+}
+
+#define COND_EVALUATE_FUNCTIONS(suffix, type) \
+COND_EVALUATE_FUNCTION(cond_changed_##suffix, type, value != c->last_value && c->last_value != MEMCON_VALUE_UNSET) \
+COND_EVALUATE_FUNCTION(cond_equal_##suffix, type, value == c->value) \
+COND_EVALUATE_FUNCTION(cond_not_equal_##suffix, type, value != c->value) \
+COND_EVALUATE_FUNCTION(cond_greater_##suffix, type, value > c->value) \
+COND_EVALUATE_FUNCTION(cond_less_##suffix, type, value < c->value)
+
+COND_EVALUATE_FUNCTIONS(u8, uint8_t)
+COND_EVALUATE_FUNCTIONS(u16, uint16_t)
+COND_EVALUATE_FUNCTIONS(u32, uint32_t)
+COND_EVALUATE_FUNCTIONS(u64, uint64_t)
+
+static const retro_core_condition_evaluate_t cond_evaluate_functions[4][5] = {
+    {cond_changed_u8, cond_equal_u8, cond_not_equal_u8, cond_greater_u8, cond_less_u8},
+    {cond_changed_u16, cond_equal_u16, cond_not_equal_u16, cond_greater_u16, cond_less_u16},
+    {cond_changed_u32, cond_equal_u32, cond_not_equal_u32, cond_greater_u32, cond_less_u32},
+    {cond_changed_u64, cond_equal_u64, cond_not_equal_u64, cond_greater_u64, cond_less_u64}
+};
+
+static int compare_condition_ops(const void *a, const void *b) {
+    const struct retro_core_memory_condition *x = ((const struct retro_core_condition_op *)a)->condition;
+    const struct retro_core_memory_condition *y = ((const struct retro_core_condition_op *)b)->condition;
+
+    if (x->snapshot != y->snapshot) return (x->snapshot > y->snapshot) - (x->snapshot < y->snapshot);
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+//Free compiled operations and regions, but keep the expression program.
+static void free_core_condition_ops(struct retro_core_condition_plan *plan) {
+    if (plan->ops) free(plan->ops);
+    if (plan->regions) free(plan->regions);
+    if (plan->op_regions) free(plan->op_regions);
+    if (plan->region_data) free((void *)plan->region_data);
+    if (plan->nr_region_data) free(plan->nr_region_data);
+
+    plan->ops = NULL;
+    plan->nr_ops = 0;
+    plan->regions = NULL;
+    plan->nr_regions = 0;
+    plan->op_regions = NULL;
+    plan->region_data = NULL;
+    plan->nr_region_data = NULL;
+}
+
+bool free_core_condition_plan(struct retro_core_condition_plan *plan) {
+    if (!plan) {
+        fprintf(ERROR_FILE, "free_core_condition_plan: Invalid plan!\n");
+        return false;
+    }
+
+    free_core_condition_ops(plan);
+    if (plan->instructions) free(plan->instructions);
+    if (plan->states) free(plan->states);
+
+    memset(plan, 0, sizeof(struct retro_core_condition_plan));
+
+    return true;
+}
+
+//Append an instruction to the expression program and return its index, or SIZE_MAX on failure.
+static size_t add_condition_instruction(struct retro_core_condition_plan *plan, const unsigned op, const size_t a, const size_t b, const size_t c) {
+    if (plan->nr_instructions == plan->max_instructions) {
+        const size_t max_instructions = (plan->max_instructions == 0 ? 64 : 2*plan->max_instructions);
+        struct retro_core_condition_instruction *instructions = (struct retro_core_condition_instruction *)realloc(plan->instructions, max_instructions*sizeof(struct retro_core_condition_instruction));
+
+        if (!instructions) {
+            fprintf(ERROR_FILE, "add_condition_instruction: Unable to allocate memory!\n");
+            return SIZE_MAX;
+        }
+
+        plan->instructions = instructions;
+        plan->max_instructions = max_instructions;
+    }
+
+    struct retro_core_condition_instruction *in = &plan->instructions[plan->nr_instructions];
+
+    in->op = op;
+    in->a = a;
+    in->b = b;
+    in->c = c;
+
+    return plan->nr_instructions++;
+}
+
+enum condition_group_type {
+    CONDGROUP_ANY = 0,
+    CONDGROUP_ALL = 1,
+    CONDGROUP_SEQUENCE = 2
+};
+
+#define CONDITION_MAX_DEPTH 32
+#define CONDITION_MAX_MODIFIERS 8
+
+/** Struct describing a group that is still open while compiling a condition expression. Jumps to the end of the group are chained through their targets until the group is closed. */
+struct condition_group {
+    unsigned type; /**< @see condition_group_type */
+    unsigned modifiers[CONDITION_MAX_MODIFIERS]; /**< Modifiers to apply once the group is closed. */
+    size_t nr_modifiers;
+    size_t nr_children;
+    size_t state; /**< Sequence state index. */
+    size_t end_chain; /**< Last jump to the end of the group. */
+    size_t advance_chain; /**< Last sequence advance awaiting the number of steps. */
+    size_t skip; /**< Sequence skip awaiting the start of the next step. */
+    size_t start; /**< First instruction of the group. */
+};
+
+static void begin_condition_group(struct condition_group *g, const unsigned type, struct retro_core_condition_plan *plan) {
+    memset(g, 0, sizeof(struct condition_group));
+    g->type = type;
+    g->end_chain = SIZE_MAX;
+    g->advance_chain = SIZE_MAX;
+    g->skip = SIZE_MAX;
+    g->start = plan->nr_instructions;
+    if (type == CONDGROUP_SEQUENCE) g->state = plan->nr_states++;
+}
+
+static bool begin_condition_child(struct condition_group *g, struct retro_core_condition_plan *plan) {
+    if (g->type != CONDGROUP_SEQUENCE) return true;
+
+    //Only evaluate a sequence step while the sequence is waiting for it.
+    if (g->skip != SIZE_MAX) plan->instructions[g->skip].c = plan->nr_instructions;
+    g->skip = add_condition_instruction(plan, CONDOP_SEQ_SKIP, g->state, g->nr_children, SIZE_MAX);
+
+    return g->skip != SIZE_MAX;
+}
+
+static bool end_condition_child(struct condition_group *g, struct retro_core_condition_plan *plan) {
+    size_t i = 0;
+
+    switch (g->type) {
+        case CONDGROUP_ANY:
+            if ((i = add_condition_instruction(plan, CONDOP_JUMP_IF_TRUE, g->end_chain, 0, 0)) == SIZE_MAX) return false;
+            g->end_chain = i;
+            break;
+        case CONDGROUP_ALL:
+            if ((i = add_condition_instruction(plan, CONDOP_JUMP_IF_FALSE, g->end_chain, 0, 0)) == SIZE_MAX) return false;
+            g->end_chain = i;
+            break;
+        case CONDGROUP_SEQUENCE:
+            if ((i = add_condition_instruction(plan, CONDOP_SEQ_ADVANCE, g->state, 0, g->advance_chain)) == SIZE_MAX) return false;
+            g->advance_chain = i;
+            if ((i = add_condition_instruction(plan, CONDOP_JUMP, g->end_chain, 0, 0)) == SIZE_MAX) return false;
+            g->end_chain = i;
+            break;
+    }
+
+    g->nr_children++;
+
+    return true;
+}
+
+//Apply modifiers in reverse order, such that 'not rise' negates the rising edge.
+static bool add_condition_modifiers(const unsigned *modifiers, const size_t nr_modifiers, struct retro_core_condition_plan *plan) {
+    for (size_t i = nr_modifiers; i-- > 0; ) {
+        const size_t state = (modifiers[i] == CONDOP_NOT ? 0 : plan->nr_states++);
+
+        if (add_condition_instruction(plan, modifiers[i], state, 0, 0) == SIZE_MAX) return false;
+    }
+
+    return true;
+}
+
+static bool has_condition_edge(const unsigned *modifiers, const size_t nr_modifiers) {
+    for (size_t i = 0; i < nr_modifiers; ++i) {
+        if (modifiers[i] == CONDOP_RISE || modifiers[i] == CONDOP_FALL) return true;
+    }
+
+    return false;
+}
+
+//Move the jump target of an instruction along with the instructions it refers to.
+static void relocate_condition_instruction(struct retro_core_condition_instruction *in, const size_t from, const size_t to) {
+    if (in->op == CONDOP_JUMP || in->op == CONDOP_JUMP_IF_FALSE || in->op == CONDOP_JUMP_IF_TRUE) in->a = in->a - from + to;
+    else if (in->op == CONDOP_SEQ_SKIP) in->c = in->c - from + to;
+}
+
+//Move a child starting at instruction start into the prologue, such that its edge states are updated at every check instead of only when no group short-circuits past it, and load its stored result in its place.
+static bool hoist_condition_child(const size_t start, struct retro_core_condition_plan *plan, struct retro_core_condition_plan *prologue) {
+    const size_t offset = prologue->nr_instructions;
+    const size_t state = plan->nr_states++;
+
+    for (size_t i = start; i < plan->nr_instructions; ++i) {
+        struct retro_core_condition_instruction in = plan->instructions[i];
+
+        relocate_condition_instruction(&in, start, offset);
+        if (add_condition_instruction(prologue, in.op, in.a, in.b, in.c) == SIZE_MAX) return false;
+    }
+
+    plan->nr_instructions = start;
+
+    return add_condition_instruction(prologue, CONDOP_STORE, state, 0, 0) != SIZE_MAX &&
+           add_condition_instruction(plan, CONDOP_LOAD, state, 0, 0) != SIZE_MAX;
+}
+
+//Place the prologue in front of the program.
+static bool prepend_condition_prologue(struct retro_core_condition_plan *plan, struct retro_core_condition_plan *prologue) {
+    if (prologue->nr_instructions == 0) return true;
+
+    const size_t offset = prologue->nr_instructions;
+
+    for (size_t i = 0; i < plan->nr_instructions; ++i) {
+        struct retro_core_condition_instruction in = plan->instructions[i];
+
+        relocate_condition_instruction(&in, 0, offset);
+        if (add_condition_instruction(prologue, in.op, in.a, in.b, in.c) == SIZE_MAX) return false;
+    }
+
+    free(plan->instructions);
+    plan->instructions = prologue->instructions;
+    plan->nr_instructions = prologue->nr_instructions;
+    plan->max_instructions = prologue->max_instructions;
+    prologue->instructions = NULL;
+    prologue->nr_instructions = 0;
+    prologue->max_instructions = 0;
+
+    return true;
+}
+
+static bool end_condition_group(struct condition_group *g, struct retro_core_condition_plan *plan) {
+    //Value of the group if no child decided it.
+    if (g->type == CONDGROUP_SEQUENCE) {
+        if (g->skip != SIZE_MAX) plan->instructions[g->skip].c = plan->nr_instructions;
+        if (add_condition_instruction(plan, CONDOP_CONST, 0, 0, 0) == SIZE_MAX) return false;
+    }
+    else if (g->nr_children == 0) {
+        if (add_condition_instruction(plan, CONDOP_CONST, g->type == CONDGROUP_ALL, 0, 0) == SIZE_MAX) return false;
+    }
+
+    //Resolve jump chains.
+    for (size_t i = g->end_chain; i != SIZE_MAX; ) {
+        const size_t next = plan->instructions[i].a;
+
+        plan->instructions[i].a = plan->nr_instructions;
+        i = next;
+    }
+
+    for (size_t i = g->advance_chain; i != SIZE_MAX; ) {
+        const size_t next = plan->instructions[i].c;
+
+        plan->instructions[i].b = g->nr_children;
+        plan->instructions[i].c = 0;
+        i = next;
+    }
+
+    return add_condition_modifiers(g->modifiers, g->nr_modifiers, plan);
+}
+
+bool core_compile_conditions(struct retro_core_condition_plan *plan, struct retro_core_memory_condition *conds, const size_t nr_conds) {
+    if (!plan || (!conds && nr_conds > 0)) {
+        fprintf(ERROR_FILE, "core_compile_conditions: Invalid plan or conditions!\n");
+        return false;
+    }
+
+    free_core_condition_ops(plan);
+
+    if (plan->states) free(plan->states);
+    plan->states = NULL;
+
+    if (nr_conds == 0) return true;
+
+    //Without an expression program, any condition triggers.
+    if (plan->nr_instructions == 0) {
+        struct condition_group g;
+
+        plan->nr_states = 0;
+        begin_condition_group(&g, CONDGROUP_ANY, plan);
+
+        for (size_t i = 0; i < nr_conds; ++i) {
+            if (add_condition_instruction(plan, CONDOP_LEAF, i, 0, 0) == SIZE_MAX || !end_condition_child(&g, plan)) {
+                free_core_condition_plan(plan);
+                return false;
+            }
+        }
+
+        if (!end_condition_group(&g, plan)) {
+            free_core_condition_plan(plan);
+            return false;
+        }
+    }
+
+    size_t *cond_ops = (size_t *)malloc(nr_conds*sizeof(size_t));
+
+    plan->ops = (struct retro_core_condition_op *)calloc(nr_conds, sizeof(struct retro_core_condition_op));
+    plan->regions = (struct retro_core_condition_region *)calloc(nr_conds, sizeof(struct retro_core_condition_region));
+    plan->op_regions = (size_t *)calloc(nr_conds, sizeof(size_t));
+    plan->region_data = (const uint8_t **)calloc(nr_conds, sizeof(const uint8_t *));
+    plan->nr_region_data = (size_t *)calloc(nr_conds, sizeof(size_t));
+    plan->states = (size_t *)calloc(plan->nr_states + 1, sizeof(size_t));
+
+    if (!cond_ops || !plan->ops || !plan->regions || !plan->op_regions || !plan->region_data || !plan->nr_region_data || !plan->states) {
+        fprintf(ERROR_FILE, "core_compile_conditions: Unable to allocate plan!\n");
+        if (cond_ops) free(cond_ops);
+        free_core_condition_plan(plan);
+        return false;
+    }
+
+    //Select an evaluation function for each valid condition.
+    for (size_t i = 0; i < nr_conds; ++i) {
+        struct retro_core_memory_condition *c = &conds[i];
+
+        if (c->type > MEMCON_VAR_64BIT) {
+            fprintf(ERROR_FILE, "core_compile_conditions: Invalid data type %u!\n", c->type);
+            continue;
+        }
+
+        if (c->compare > MEMCON_CMP_LESS) {
+            fprintf(ERROR_FILE, "core_compile_conditions: Invalid data comparison %u!\n", c->compare);
+            continue;
+        }
+
+        plan->ops[plan->nr_ops].evaluate = cond_evaluate_functions[c->type][c->compare];
+        plan->ops[plan->nr_ops].condition = c;
+        plan->ops[plan->nr_ops].end = c->offset + ((size_t)1 << c->type);
+        plan->nr_ops++;
+    }
+
+    //Group conditions by memory region such that each region is looked up once per check.
+    qsort(plan->ops, plan->nr_ops, sizeof(struct retro_core_condition_op), compare_condition_ops);
+
+    for (size_t i = 0; i < plan->nr_ops; ++i) {
+        const struct retro_core_condition_op *op = &plan->ops[i];
+        struct retro_core_condition_region *r = &plan->regions[plan->nr_regions > 0 ? plan->nr_regions - 1 : 0];
+
+        if (plan->nr_regions == 0 || r->snapshot != op->condition->snapshot) {
+            r = &plan->regions[plan->nr_regions++];
+            r->snapshot = op->condition->snapshot;
+            r->first_op = i;
+            r->nr_ops = 0;
+            r->max_end = 0;
+        }
+
+        r->nr_ops++;
+        if (op->end > r->max_end) r->max_end = op->end;
+        plan->op_regions[i] = plan->nr_regions - 1;
+    }
+
+    //Let the program refer to sorted operations instead of conditions, invalid conditions are never satisfied.
+    for (size_t i = 0; i < nr_conds; ++i) cond_ops[i] = SIZE_MAX;
+    for (size_t i = 0; i < plan->nr_ops; ++i) cond_ops[plan->ops[i].condition - conds] = i;
+
+    for (size_t i = 0; i < plan->nr_instructions; ++i) {
+        struct retro_core_condition_instruction *in = &plan->instructions[i];
+
+        if (in->op == CONDOP_LEAF) in->a = (in->a < nr_conds ? cond_ops[in->a] : SIZE_MAX);
+        else if (in->op == CONDOP_RISE || in->op == CONDOP_FALL) plan->states[in->a] = CONDITION_STATE_UNSET;
+    }
+
+    free(cond_ops);
+
+    fprintf(CORE_FILE, "Compiled %zu conditions into %zu memory regions and %zu instructions.\n", plan->nr_ops, plan->nr_regions, plan->nr_instructions);
+
+    return true;
+}
+
+bool core_check_condition_plan(const struct retro_core *core, struct retro_core_condition_plan *plan) {
+    if (!core || !plan) {
+        fprintf(ERROR_FILE, "core_check_condition_plan: Invalid core or plan!\n");
+        return false;
+    }
+
+    if (plan->nr_ops == 0) return false;
+
+    //Look up every memory region once.
+    for (size_t i = 0; i < plan->nr_regions; ++i) {
+        const struct retro_core_condition_region *r = &plan->regions[i];
+
+        plan->region_data[i] = get_snapshot_memory(core, r->snapshot, &plan->nr_region_data[i]);
+
+        if (!plan->region_data[i] || plan->nr_region_data[i] == 0) {
+            fprintf(ERROR_FILE, "core_check_conditions: Invalid snapshot index %zx!\n", r->snapshot);
+            plan->region_data[i] = NULL;
+        }
+        else if (r->max_end <= plan->nr_region_data[i]) {
+            //Mark regions that need no per-condition bounds check.
+            plan->nr_region_data[i] = SIZE_MAX;
+        }
+    }
+
+    //Evaluate expression program with short-circuiting, edges were moved to the front such that they are always evaluated.
+    const struct retro_core_condition_instruction *instructions = plan->instructions;
+    size_t *states = plan->states;
+    bool value = false;
+
+    for (size_t pc = 0; pc < plan->nr_instructions; ) {
+        const struct retro_core_condition_instruction *in = &instructions[pc++];
+
+        switch (in->op) {
+            case CONDOP_LEAF:
+                value = false;
+
+                if (in->a != SIZE_MAX) {
+                    const struct retro_core_condition_op *op = &plan->ops[in->a];
+                    const size_t r = plan->op_regions[in->a];
+
+                    if (!plan->region_data[r]) break;
+                    if (op->end > plan->nr_region_data[r]) fprintf(ERROR_FILE, "core_check_conditions: Invalid snapshot offset %zx (> %zx) in %zx!\n", op->condition->offset, plan->nr_region_data[r], op->condition->snapshot);
+                    else value = op->evaluate(plan->region_data[r], op->condition);
+                }
+                break;
+            case CONDOP_CONST:
+                value = (in->a != 0);
+                break;
+            case CONDOP_NOT:
+                value = !value;
+                break;
+            case CONDOP_RISE:
+            {
+                const size_t last = states[in->a];
+
+                states[in->a] = value;
+                value = (value && last == 0);
+                break;
+            }
+            case CONDOP_FALL:
+            {
+                const size_t last = states[in->a];
+
+                states[in->a] = value;
+                value = (!value && last == 1);
+                break;
+            }
+            case CONDOP_JUMP:
+                pc = in->a;
+                break;
+            case CONDOP_JUMP_IF_FALSE:
+                if (!value) pc = in->a;
+                break;
+            case CONDOP_JUMP_IF_TRUE:
+                if (value) pc = in->a;
+                break;
+            case CONDOP_SEQ_SKIP:
+                if (states[in->a] != in->b) pc = in->c;
+                break;
+            case CONDOP_SEQ_ADVANCE:
+                if (value) {
+                    if (++states[in->a] >= in->b) states[in->a] = 0;
+                    else value = false;
+                }
+                break;
+            case CONDOP_STORE:
+                states[in->a] = value;
+                break;
+            case CONDOP_LOAD:
+                value = (states[in->a] != 0);
+                break;
+            default:
+                fprintf(ERROR_FILE, "core_check_condition_plan: Invalid instruction %u!\n", in->op);
+                return false;
+        }
+    }
+
+    return value;
+}
+
+//Parse a single condition expression keyword, returning false if the token is not a keyword.
+static bool parse_condition_keyword(const char *token, unsigned *modifier, unsigned *group, bool *end) {
+    *modifier = UINT_MAX;
+    *group = UINT_MAX;
+    *end = false;
+
+    if (strcmp(token, "not") == 0) *modifier = CONDOP_NOT;
+    else if (strcmp(token, "rise") == 0) *modifier = CONDOP_RISE;
+    else if (strcmp(token, "fall") == 0) *modifier = CONDOP_FALL;
+    else if (strcmp(token, "any") == 0) *group = CONDGROUP_ANY;
+    else if (strcmp(token, "all") == 0) *group = CONDGROUP_ALL;
+    else if (strcmp(token, "sequence") == 0) *group = CONDGROUP_SEQUENCE;
+    else if (strcmp(token, "end") == 0) *end = true;
+    else return false;
+
+    return true;
+}
+
+//Close the innermost open group and add it as a child of its parent.
+static bool close_condition_group(struct condition_group *groups, const size_t nr_groups, struct retro_core_condition_plan *plan, struct retro_core_condition_plan *prologue) {
+    struct condition_group *g = &groups[nr_groups - 1];
+
+    if (!end_condition_group(g, plan)) return false;
+    if (has_condition_edge(g->modifiers, g->nr_modifiers) && !hoist_condition_child(g->start, plan, prologue)) return false;
+
+    return end_condition_child(&groups[nr_groups - 2], plan);
+}
+
+bool core_load_conditions_from_file(struct retro_core_memory_condition **conds_p, size_t *nr_conds_p, struct retro_core_condition_plan *plan, const char *file) {
+    if (!conds_p || !nr_conds_p || !plan || !file) {
+        fprintf(ERROR_FILE, "core_load_conditions_from_file: Invalid conditions, plan, or file!\n");
         return false;
     }
 
     struct retro_core_memory_condition *conds = NULL;
     size_t nr_conds = 0;
+    struct condition_group groups[CONDITION_MAX_DEPTH];
+    size_t nr_groups = 1;
+    struct retro_core_condition_plan prologue;
+    bool result = true;
     
     FILE *f = fopen(file, "r");
     char line[NR_CORE_OPTION_LINE];
@@ -1095,34 +2132,117 @@ bool core_load_conditions_from_file(struct retro_core_memory_condition **conds_p
         return false;
     }
 
-    while (fgets(line, NR_CORE_OPTION_LINE, f)) {
+    //The top level of the file behaves as an 'any' group.
+    free_core_condition_plan(plan);
+    memset(&prologue, 0, sizeof(struct retro_core_condition_plan));
+    begin_condition_group(&groups[0], CONDGROUP_ANY, plan);
+
+    while (result && fgets(line, NR_CORE_OPTION_LINE, f)) {
+        unsigned modifiers[CONDITION_MAX_MODIFIERS];
+        size_t nr_modifiers = 0;
+        unsigned modifier = UINT_MAX, group = UINT_MAX;
+        bool end = false;
+        char *token = line;
+        int nr_chars = 0;
+        char word[16];
+
         if (IS_COMMENT_LINE(line)) continue;
-        
-        nr_conds++;
 
-        if (!(conds = (struct retro_core_memory_condition *)realloc(conds, nr_conds*sizeof(struct retro_core_memory_condition)))) {
-            fprintf(ERROR_FILE, "core_load_conditions_from_file: Unable to allocate memory!\n");
-            fclose(f);
-            return false;
+        //Gather keywords in front of the condition.
+        while (sscanf(token, " %15s%n", word, &nr_chars) == 1 && parse_condition_keyword(word, &modifier, &group, &end) && modifier != UINT_MAX) {
+            if (nr_modifiers < CONDITION_MAX_MODIFIERS) modifiers[nr_modifiers++] = modifier;
+            else fprintf(ERROR_FILE, "core_load_conditions_from_file: Too many modifiers in line '%s'!\n", line);
+            token += nr_chars;
         }
 
-        struct retro_core_memory_condition *c = conds + (nr_conds - 1);
+        if (sscanf(token, " %15s", word) != 1 || IS_COMMENT_LINE(word)) {
+            if (nr_modifiers > 0) fprintf(ERROR_FILE, "core_load_conditions_from_file: Missing condition after modifiers in line '%s'!\n", line);
+            continue;
+        }
 
-        memset(c, 0, sizeof(struct retro_core_memory_condition));
-        c->last_value = MEMCON_VALUE_UNSET;
-        
-        if (sscanf(line, "%zx %zx %x %x %lx", &c->snapshot, &c->offset, &c->type, &c->compare, &c->value) != 5) {
-            fprintf(ERROR_FILE, "core_load_conditions_from_file: Unable to process line '%s'!\n", line);
-            nr_conds--;
+        if (end) {
+            if (nr_modifiers > 0) fprintf(ERROR_FILE, "core_load_conditions_from_file: Ignoring modifiers before 'end' in line '%s'!\n", line);
+
+            if (nr_groups <= 1) {
+                fprintf(ERROR_FILE, "core_load_conditions_from_file: Unmatched 'end' in '%s'!\n", file);
+                continue;
+            }
+
+            result = close_condition_group(groups, nr_groups, plan, &prologue);
+            nr_groups--;
+        }
+        else if (group != UINT_MAX) {
+            if (nr_groups >= CONDITION_MAX_DEPTH) {
+                fprintf(ERROR_FILE, "core_load_conditions_from_file: Conditions are nested too deeply in '%s'!\n", file);
+                result = false;
+                break;
+            }
+
+            result = begin_condition_child(&groups[nr_groups - 1], plan);
+            begin_condition_group(&groups[nr_groups], group, plan);
+            memcpy(groups[nr_groups].modifiers, modifiers, nr_modifiers*sizeof(unsigned));
+            groups[nr_groups].nr_modifiers = nr_modifiers;
+            nr_groups++;
+        }
+        else {
+            struct retro_core_memory_condition c;
+
+            memset(&c, 0, sizeof(struct retro_core_memory_condition));
+            c.last_value = MEMCON_VALUE_UNSET;
+
+            if (sscanf(token, "%zx %zx %x %x %lx", &c.snapshot, &c.offset, &c.type, &c.compare, &c.value) != 5) {
+                fprintf(ERROR_FILE, "core_load_conditions_from_file: Unable to process line '%s'!\n", line);
+                continue;
+            }
+
+            struct retro_core_memory_condition *new_conds = (struct retro_core_memory_condition *)realloc(conds, (nr_conds + 1)*sizeof(struct retro_core_memory_condition));
+
+            if (!new_conds) {
+                fprintf(ERROR_FILE, "core_load_conditions_from_file: Unable to allocate memory!\n");
+                result = false;
+                break;
+            }
+
+            conds = new_conds;
+            conds[nr_conds] = c;
+
+            result = begin_condition_child(&groups[nr_groups - 1], plan);
+
+            const size_t start = plan->nr_instructions;
+
+            result = result &&
+                     add_condition_instruction(plan, CONDOP_LEAF, nr_conds, 0, 0) != SIZE_MAX &&
+                     add_condition_modifiers(modifiers, nr_modifiers, plan) &&
+                     (!has_condition_edge(modifiers, nr_modifiers) || hoist_condition_child(start, plan, &prologue)) &&
+                     end_condition_child(&groups[nr_groups - 1], plan);
+            nr_conds++;
         }
     }
 
     fclose(f);
 
+    if (result && nr_groups > 1) {
+        fprintf(ERROR_FILE, "core_load_conditions_from_file: Missing %zu 'end' lines in '%s'!\n", nr_groups - 1, file);
+
+        while (result && nr_groups > 1) {
+            result = close_condition_group(groups, nr_groups, plan, &prologue);
+            nr_groups--;
+        }
+    }
+
+    if (result) result = end_condition_group(&groups[0], plan) && prepend_condition_prologue(plan, &prologue);
+    if (prologue.instructions) free(prologue.instructions);
+
+    if (!result) {
+        if (conds) free(conds);
+        free_core_condition_plan(plan);
+        return false;
+    }
+
     *conds_p = conds;
     *nr_conds_p = nr_conds;
 
-    fprintf(CORE_FILE, "Read %zu conditions from '%s'.\n", nr_conds, file);
+    fprintf(CORE_FILE, "Read %zu conditions and %zu instructions from '%s'.\n", nr_conds, plan->nr_instructions, file);
     
     return true;
 }
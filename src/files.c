@@ -12,6 +12,7 @@ You should have received a copy of the GNU General Public License along with Ret
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 
 #ifdef _WIN32
 #include <io.h>
@@ -87,3 +88,61 @@ int create_directory(const char *path) {
 #endif
 }
 
+//Get a 64-bit FNV-1a hash and the size of the contents of a file.
+int hash_file(const char *file, uint64_t *hash, size_t *size) {
+    if (!file || !hash || !size) return 0;
+
+    FILE *fid = fopen(file, "rb");
+
+    if (!fid) return 0;
+
+    uint8_t buffer[65536];
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t len, nr = 0;
+
+    while ((len = fread(buffer, 1, sizeof(buffer), fid)) > 0) {
+        for (size_t i = 0; i < len; ++i) {
+            h = (h ^ buffer[i])*0x100000001b3ull;
+        }
+
+        nr += len;
+    }
+
+    const int ok = !ferror(fid);
+
+    fclose(fid);
+    *hash = h;
+    *size = nr;
+
+    return ok;
+}
+
+//Copy the contents of file src to file dst, overwriting dst.
+int copy_file(const char *dst, const char *src) {
+    if (!dst || !src) return 0;
+
+    FILE *in = fopen(src, "rb");
+
+    if (!in) return 0;
+
+    FILE *out = fopen(dst, "wb");
+
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+
+    uint8_t buffer[65536];
+    size_t len;
+    int ok = 1;
+
+    while (ok && (len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        ok = (fwrite(buffer, 1, len, out) == len);
+    }
+
+    ok = ok && !ferror(in);
+    fclose(in);
+    if (fclose(out) != 0) ok = 0;
+
+    return ok;
+}
@@ -0,0 +1,164 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "retrogauntlet.h"
+#include "framepacer.h"
+
+//Timer inaccuracy of SDL_Delay() that is covered by spinning.
+#define FRAME_PACER_SPIN_SECONDS 0.002
+//Maximum relative mismatch between the display and core frame rates for vsync-locked pacing.
+#define FRAME_PACER_MAX_RATE_MISMATCH 0.01
+
+bool create_frame_pacer(struct frame_pacer *pacer, const unsigned policy, const size_t max_skip) {
+    if (!pacer || policy > FRAME_PACER_ADAPTIVE) {
+        fprintf(ERROR_FILE, "create_frame_pacer: Invalid pacer or policy!\n");
+        return false;
+    }
+
+    memset(pacer, 0, sizeof(struct frame_pacer));
+    pacer->policy = policy;
+    pacer->frequency = (double)SDL_GetPerformanceFrequency();
+    pacer->spin_ticks = (uint64_t)(FRAME_PACER_SPIN_SECONDS*pacer->frequency);
+    pacer->swap_interval = 1;
+    pacer->max_skip = max_skip;
+
+    return true;
+}
+
+void frame_pacer_restart(struct frame_pacer *pacer, const bool reset_counters) {
+    if (!pacer) return;
+
+    pacer->start_counter = 0;
+    pacer->nr_frames = 0;
+
+    if (reset_counters) {
+        pacer->nr_skipped_frames = 0;
+        pacer->nr_dropped_frames = 0;
+    }
+}
+
+//Select swap interval and whether the display paces frames.
+static void frame_pacer_setup(struct frame_pacer *pacer, SDL_Window *window, const double frames_per_second) {
+    pacer->frame_ticks = pacer->frequency/(frames_per_second > 0.0 ? frames_per_second : 60.0);
+    pacer->refresh_rate = 0.0;
+
+    //Without a window we are pacing a thread that does not swap buffers, which only needs a timer.
+    if (!window) {
+        pacer->display_locked = false;
+        pacer->swap_interval = 0;
+        return;
+    }
+
+    SDL_DisplayMode mode;
+    const int display = SDL_GetWindowDisplayIndex(window);
+
+    if (display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 && mode.refresh_rate > 0) pacer->refresh_rate = mode.refresh_rate;
+
+    //Number of refreshes per emulated frame if the display runs at an integer multiple of the core.
+    int nr_refreshes = 0;
+
+    if (pacer->refresh_rate > 0.0 && frames_per_second > 0.0) {
+        const double ratio = pacer->refresh_rate/frames_per_second;
+
+        nr_refreshes = (int)floor(ratio + 0.5);
+        if (nr_refreshes < 1 || fabs(ratio - nr_refreshes) > FRAME_PACER_MAX_RATE_MISMATCH*nr_refreshes) nr_refreshes = 0;
+    }
+
+    pacer->display_locked = (nr_refreshes > 0 && pacer->policy != FRAME_PACER_FREE_RUN);
+
+    switch (pacer->policy) {
+        case FRAME_PACER_VSYNC:
+            pacer->swap_interval = (pacer->display_locked ? nr_refreshes : 1);
+            break;
+        case FRAME_PACER_FREE_RUN:
+            pacer->swap_interval = 0;
+            break;
+        case FRAME_PACER_ADAPTIVE:
+            pacer->swap_interval = (pacer->display_locked ? -nr_refreshes : 0);
+            break;
+    }
+
+    //Fall back to regular vsync if adaptive vsync is not supported.
+    if (SDL_GL_SetSwapInterval(pacer->swap_interval) != 0 && pacer->swap_interval < 0) {
+        pacer->swap_interval = -pacer->swap_interval;
+        SDL_GL_SetSwapInterval(pacer->swap_interval);
+    }
+
+    fprintf(INFO_FILE, "Pacing %.3f fps on a %.0f Hz display with swap interval %d (%s).\n", frames_per_second, pacer->refresh_rate, pacer->swap_interval, pacer->display_locked ? "vsync-locked" : "timer");
+}
+
+void frame_pacer_begin_frame(struct frame_pacer *pacer, SDL_Window *window, const double frames_per_second) {
+    if (!pacer) return;
+
+    if (pacer->start_counter == 0) {
+        frame_pacer_setup(pacer, window, frames_per_second);
+        pacer->start_counter = SDL_GetPerformanceCounter();
+        pacer->nr_frames = 0;
+    }
+
+    pacer->nr_frames++;
+    pacer->presented = true;
+}
+
+//Sleep until shortly before the deadline, then spin for sub-millisecond accuracy.
+static void frame_pacer_wait_until(const struct frame_pacer *pacer, const uint64_t deadline) {
+    uint64_t now;
+
+    while ((now = SDL_GetPerformanceCounter()) < deadline) {
+        if (deadline - now > pacer->spin_ticks) {
+            SDL_Delay((Uint32)(1000.0*(double)(deadline - now - pacer->spin_ticks)/pacer->frequency) + 1);
+        }
+    }
+}
+
+size_t frame_pacer_end_frame(struct frame_pacer *pacer) {
+    if (!pacer || pacer->start_counter == 0) return 0;
+
+    const uint64_t now = SDL_GetPerformanceCounter();
+    const uint64_t deadline = pacer->start_counter + (uint64_t)(pacer->frame_ticks*(double)pacer->nr_frames);
+    const uint64_t frame_ticks = (uint64_t)pacer->frame_ticks;
+
+    if (pacer->display_locked) {
+        //The buffer swap paces frames, only wait if vsync does not seem to be working or if we did not swap.
+        if (!pacer->presented) frame_pacer_wait_until(pacer, deadline);
+        else if (now + frame_ticks < deadline) frame_pacer_wait_until(pacer, deadline - frame_ticks);
+        
+        //Follow the display clock instead of accumulating drift.
+        if (now > deadline + frame_ticks) pacer->start_counter += now - deadline - frame_ticks;
+
+        return 0;
+    }
+
+    if (now < deadline) {
+        frame_pacer_wait_until(pacer, deadline);
+        return 0;
+    }
+
+    //Skip at most max_skip frames and drop the others, e.g., after loading or window dragging.
+    const size_t nr_behind = (size_t)((double)(now - deadline)/pacer->frame_ticks) + 1;
+
+    if (nr_behind > pacer->max_skip) {
+        const size_t nr_dropped = nr_behind - pacer->max_skip;
+
+        pacer->start_counter += (uint64_t)(pacer->frame_ticks*(double)nr_dropped);
+        pacer->nr_dropped_frames += nr_dropped;
+    }
+
+    const size_t nr_skip = (nr_behind < pacer->max_skip ? nr_behind : pacer->max_skip);
+
+    pacer->nr_skipped_frames += nr_skip;
+
+    return nr_skip;
+}
+
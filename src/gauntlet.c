@@ -49,12 +49,19 @@ static int gauntlet_ini_handler(void *user, const char *section, const char *nam
             g->mouse_button_mask = SDL_BUTTON_MMASK;
         }
     }
+    if (strcmp(section, "rom") == 0 && strcmp(name, "runahead") == 0) {
+        const int nr_frames = atoi(value);
+
+        g->nr_runahead_frames = (size_t)max(0, min(nr_frames, MAX_RETRO_GAUNTLET_RUNAHEAD_FRAMES));
+        if ((size_t)nr_frames != g->nr_runahead_frames) fprintf(WARN_FILE, "gauntlet_ini_handler: Clamped run-ahead of %d to %zu frames!\n", nr_frames, g->nr_runahead_frames);
+    }
     if (strcmp(section, "rom") == 0 && strcmp(name, "controller") == 0) g->enable_controller = (strcmp(value, "yes") == 0);
     
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "save") == 0) g->core_save_file = combine_paths(g->data_directory, value);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "win") == 0) g->win_condition_file = combine_paths(g->data_directory, value);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "lose") == 0) g->lose_condition_file = combine_paths(g->data_directory, value);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "par_time_ms") == 0) g->par_time = atoi(value);
+    if (strcmp(section, "gauntlet") == 0 && strcmp(name, "timing") == 0) g->enable_frame_timing = (strcmp(value, "wall") != 0);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "title") == 0) g->title = strdup(value);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "description") == 0) g->description = strdup(value);
     if (strcmp(section, "gauntlet") == 0 && strcmp(name, "controls") == 0) g->controls = strdup(value);
@@ -84,6 +91,8 @@ bool free_gauntlet(struct gauntlet *g) {
     if (g->controls) free(g->controls);
     if (g->win_conditions) free(g->win_conditions);
     if (g->lose_conditions) free(g->lose_conditions);
+    free_core_condition_plan(&g->win_plan);
+    free_core_condition_plan(&g->lose_plan);
 
     memset(g, 0, sizeof(struct gauntlet));
 
@@ -172,6 +181,7 @@ bool create_gauntlet(struct gauntlet *g, const char *ini_file, const char *data_
     g->mouse_button_mask = 0;
     g->enable_controller = false;
     g->enable_debug = false;
+    g->enable_frame_timing = true;
     g->status = RETRO_GAUNTLET_OFF;
 
     g->data_directory = expand_to_full_path(data_directory);
@@ -218,12 +228,15 @@ bool gauntlet_start(struct gauntlet *g, struct sdl_gl_core_interface *sgci) {
 
     //Load conditions.
     if (g->win_condition_file) {
-        if (!core_load_conditions_from_file(&g->win_conditions, &g->nr_win_conditions, g->win_condition_file)) return false;
+        if (!core_load_conditions_from_file(&g->win_conditions, &g->nr_win_conditions, &g->win_plan, g->win_condition_file)) return false;
     }
 
     if (g->lose_condition_file) {
-        if (!core_load_conditions_from_file(&g->lose_conditions, &g->nr_lose_conditions, g->lose_condition_file)) return false;
+        if (!core_load_conditions_from_file(&g->lose_conditions, &g->nr_lose_conditions, &g->lose_plan, g->lose_condition_file)) return false;
     }
+
+    if (!core_compile_conditions(&g->win_plan, g->win_conditions, g->nr_win_conditions)) return false;
+    if (!core_compile_conditions(&g->lose_plan, g->lose_conditions, g->nr_lose_conditions)) return false;
     
     //Enable desired controllers.
     sgci->enable_mouse = g->enable_mouse;
@@ -242,11 +255,21 @@ bool gauntlet_start(struct gauntlet *g, struct sdl_gl_core_interface *sgci) {
     
     //Restore save.
     if (g->core_save_file) core_unserialize_from_file(&sgci->core, g->core_save_file);
+
+    //Prepare run-ahead once the core is in its starting state.
+    if (!sdl_gl_if_start_runahead(sgci, g->nr_runahead_frames)) {
+        fprintf(WARN_FILE, "gauntlet_start: Running '%s' without run-ahead!\n", g->ini_file);
+        g->nr_runahead_frames = 0;
+    }
     
     sdl_gl_if_reset_audio(sgci);
     g->status = RETRO_GAUNTLET_RUNNING;
     g->start_time = SDL_GetTicks();
     g->end_time = g->start_time;
+    g->nr_frames = 0;
+    g->frame_ms = 0.0;
+    g->frame_time = 0;
+    g->nominal_frame_rate = false;
 
     return true;
 }
@@ -260,13 +283,20 @@ bool gauntlet_check_status(struct gauntlet *g, struct sdl_gl_core_interface *sgc
     if (g->status == RETRO_GAUNTLET_RUNNING) {
         const uint32_t t = SDL_GetTicks();
 
-        if (g->win_conditions && core_check_conditions(&sgci->core, g->win_conditions, g->nr_win_conditions, g->enable_debug)) {
+        //Emulated time only depends on the frames the core produced, not on host load.
+        g->frame_time = (uint32_t)g->frame_ms;
+
+        //Debugging monitors all conditions, otherwise use the compiled plans.
+        const bool win = (g->enable_debug ? g->win_conditions && core_check_conditions(&sgci->core, g->win_conditions, g->nr_win_conditions, true) : core_check_condition_plan(&sgci->core, &g->win_plan));
+        const bool lose = (g->enable_debug ? g->lose_conditions && core_check_conditions(&sgci->core, g->lose_conditions, g->nr_lose_conditions, true) : core_check_condition_plan(&sgci->core, &g->lose_plan));
+
+        if (win) {
             g->status = RETRO_GAUNTLET_WON;
             g->end_time = t;
         }
 
-        if ((g->lose_conditions && core_check_conditions(&sgci->core, g->lose_conditions, g->nr_lose_conditions, g->enable_debug)) ||
-            (g->status == RETRO_GAUNTLET_RUNNING && g->par_time > 0 && t > g->start_time + g->par_time)) {
+        if (lose ||
+            (g->status == RETRO_GAUNTLET_RUNNING && g->par_time > 0 && (g->enable_frame_timing ? g->frame_time : t - g->start_time) > g->par_time)) {
             g->status = RETRO_GAUNTLET_LOST;
             g->end_time = t;
         }
@@ -275,12 +305,32 @@ bool gauntlet_check_status(struct gauntlet *g, struct sdl_gl_core_interface *sgc
     return true;
 }
 
+//Count an emulated frame, such that frame rate changes by the core only affect the duration of later frames.
+void gauntlet_count_frame(struct gauntlet *g, const double frames_per_second) {
+    if (!g) return;
+
+    g->nr_frames++;
+
+    if (frames_per_second > 0.0) {
+        g->frame_ms += 1000.0/frames_per_second;
+        return;
+    }
+
+    //Never fall back to wall-clock time, such that emulated time does not depend on host load.
+    if (!g->nominal_frame_rate) fprintf(WARN_FILE, "gauntlet_count_frame: Core reports no frame rate, counting frames at %.0f fps!\n", RETRO_GAUNTLET_NOMINAL_FPS);
+    g->nominal_frame_rate = true;
+    g->frame_ms += 1000.0/RETRO_GAUNTLET_NOMINAL_FPS;
+}
+
 bool gauntlet_stop(struct gauntlet *g) {
     if (!g) {
         fprintf(ERROR_FILE, "gauntlet_start: Invalid gauntlet!\n");
         return false;
     }
 
+    free_core_condition_plan(&g->win_plan);
+    free_core_condition_plan(&g->lose_plan);
+
     if (g->win_conditions) free(g->win_conditions);
     g->win_conditions = NULL;
     g->nr_win_conditions = 0;
@@ -294,3 +344,15 @@ bool gauntlet_stop(struct gauntlet *g) {
     return true;
 }
 
+uint32_t gauntlet_get_time(const struct gauntlet *g) {
+    if (!g) return 0;
+
+    return (g->enable_frame_timing ? g->frame_time : g->end_time - g->start_time);
+}
+
+uint32_t gauntlet_get_wall_time(const struct gauntlet *g) {
+    if (!g) return 0;
+
+    return g->end_time - g->start_time;
+}
+
@@ -40,11 +40,11 @@ void game_sort_player_indices_by_finish_time(struct gauntlet_game *game) {
     //Use simple insertion sort.
     if (!game) return;
 
-    for (int i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 0; i < game->nr_players; ++i) {
         game->player_indices[i] = i;
     }
 
-    for (int i = 1; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 1; i < game->nr_players; ++i) {
         const int k = game->player_indices[i];
         int j;
         
@@ -72,7 +72,7 @@ bool game_player_give_points(struct gauntlet_game *game) {
     //Has everyone finished?
     bool all_finished = true;
    
-    for (int i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 0; i < game->nr_players; ++i) {
         if (game->players[i].finish_state == RETRO_GAUNTLET_RUNNING) {
             if (i == 0) all_finished = false;
             else if (i > 0 && host_is_client_active(game->host, i - 1)) all_finished = false;
@@ -92,7 +92,7 @@ bool game_player_give_points(struct gauntlet_game *game) {
 
     int i_points = 0;
 
-    for (int i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS && i_points < nr_finish_points; ++i) {
+    for (int i = 0; i < game->nr_players && i_points < nr_finish_points; ++i) {
         const int j = game->player_indices[i];
 
         if (game->players[j].finish_state == RETRO_GAUNTLET_WON && game->players[j].finish_time > 0 && (j == 0 || host_is_client_active(game->host, j - 1))) {
@@ -108,20 +108,45 @@ bool game_player_give_points(struct gauntlet_game *game) {
     return true;
 }
 
-bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_player *p) {
-    if (!game || !p || p->nr_data < 8) {
+//Whether we are connected to a host, safe to call while the client network thread is running.
+static bool game_is_client_active(struct gauntlet_game *game) {
+    return (game->client_thread && SDL_AtomicGet(&game->client_active) != 0);
+}
+
+static bool game_client_send(struct gauntlet_game *game, const void *buffer, const size_t len) {
+    if (!game_is_client_active(game)) return false;
+
+    SDL_LockMutex(game->client_mutex);
+    const bool ok = client_send(game->client, buffer, len);
+    SDL_UnlockMutex(game->client_mutex);
+
+    return ok;
+}
+
+static void game_client_set_blocking(struct gauntlet_game *game, const bool blocking) {
+    if (!game_is_client_active(game)) return;
+
+    SDL_LockMutex(game->client_mutex);
+    client_set_blocking(game->client, blocking);
+    SDL_UnlockMutex(game->client_mutex);
+}
+
+//Apply a decrypted message of nr_data bytes, including its header, sent by player p.
+bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_player *p, const uint8_t *data, const size_t nr_data) {
+    if (!game || !p || !data || nr_data < 8) {
         fprintf(ERROR_FILE, "game_player_apply_message: Invalid player, game, or message size!\n");
         return false;
     }
     
     //Apply message.
-    const uint16_t msg_type = *(uint16_t *)(p->data + 2);
+    const uint16_t msg_type = *(const uint16_t *)(data + 2);
     
     //Did we receive any invalid messages for a host?
     if (host_is_host_active(game->host)) {
         switch (msg_type) {
             case RETRO_GAUNTLET_MSG_NAME:
             case RETRO_GAUNTLET_MSG_FINISH:
+            case RETRO_GAUNTLET_MSG_MISSING:
                 //Valid to receive as host.
                 break;
             default:
@@ -130,19 +155,52 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
         }
     }
 
+    //The message is a view into a receive buffer, so make sure its fields do not extend beyond it.
+    bool truncated = false;
+
+    switch (msg_type) {
+        case RETRO_GAUNTLET_MSG_START:
+        case RETRO_GAUNTLET_MSG_FILE_START:
+            truncated = !memchr(data + 8, 0, nr_data - 8);
+            break;
+        case RETRO_GAUNTLET_MSG_FINISH:
+            truncated = (nr_data < 16);
+            break;
+        case RETRO_GAUNTLET_MSG_FILE_DATA:
+            truncated = (nr_data < 16 || *(const uint32_t *)(data + 12) > nr_data - 16);
+            break;
+        case RETRO_GAUNTLET_MSG_MANIFEST:
+            truncated = (nr_data < 12);
+            break;
+        case RETRO_GAUNTLET_MSG_MISSING:
+            truncated = (nr_data < 12 || *(const uint32_t *)(data + 8) > (nr_data - 12)/8);
+            break;
+    }
+
+    if (truncated) {
+        fprintf(ERROR_FILE, "game_player_apply_message: Message %u of %zu bytes is truncated!\n", msg_type, nr_data);
+        return false;
+    }
+
+    //Any message can alter the lobby or the menu.
+    game->lobby_changed = true;
+    game->menu_changed = true;
+
     switch (msg_type) {
         case RETRO_GAUNTLET_MSG_NAME:
             //Change player name.
-            strncpy(p->name, (char *)(p->data + 8), NR_RETRO_GAUNTLET_NAME);
+            strncpy(p->name, (const char *)(data + 8), min(NR_RETRO_GAUNTLET_NAME, nr_data - 8));
+            p->name[min(NR_RETRO_GAUNTLET_NAME, nr_data - 8)] = 0;
             break;
         case RETRO_GAUNTLET_MSG_LOBBY:
             //Update lobby text.
-            strncpy(game->lobby_text, (char *)(p->data + 8), NR_RETRO_GAUNTLET_MENU_TEXT);
+            strncpy(game->lobby_text, (const char *)(data + 8), min(NR_RETRO_GAUNTLET_MENU_TEXT, nr_data - 8));
+            game->lobby_text[min(NR_RETRO_GAUNTLET_MENU_TEXT, nr_data - 8)] = 0;
             break;
         case RETRO_GAUNTLET_MSG_START:
             //Start selected gauntlet.
             if (true) {
-                char *ini_file = combine_paths(game->menu.data_directory, (const char *)(p->data + 8));
+                char *ini_file = combine_paths(game->menu.data_directory, (const char *)(data + 8));
                 bool ok = game_start_gauntlet(game, ini_file);
 
                 if (ini_file) free(ini_file);
@@ -151,14 +209,18 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
             break;
         case RETRO_GAUNTLET_MSG_FINISH:
             //Finish gauntlet.
-            p->finish_state = *(uint32_t *)(p->data + 8);
-            p->finish_time = *(uint32_t *)(p->data + 12);
+            p->finish_state = *(const uint32_t *)(data + 8);
+            p->finish_time = *(const uint32_t *)(data + 12);
+            
+            //Older clients only report a single time.
+            p->finish_wall_time = (nr_data >= 20 ? *(const uint32_t *)(data + 16) : p->finish_time);
+            fprintf(INFO_FILE, "Player %s finished in %u ms (%u ms wall-clock).\n", p->name, p->finish_time, p->finish_wall_time);
             break;
         case RETRO_GAUNTLET_MSG_GET_FILES:
             //Get ready to receive files, change sockets to blocking.
             game_draw_message_to_screen(game, "Receiving data from host...");
 
-            if (client_is_client_active(game->client)) client_set_blocking(game->client, true);
+            game_client_set_blocking(game, true);
             break;
         case RETRO_GAUNTLET_MSG_FILE_START:
             //Start receiving file data.
@@ -167,14 +229,14 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
                 return false;
             }
 
-            game->client_recv_file = combine_paths(game->menu.data_directory, (const char *)(p->data + 8));
+            game->client_recv_file = combine_paths(game->menu.data_directory, (const char *)(data + 8));
             
             if (!game->client_recv_file) {
                 fprintf(ERROR_FILE, "game_player_apply_message: Insufficient memory for file start!\n");
                 return false;
             }
 
-            if (!game_create_subdirectory_for_file(game->menu.data_directory, (const char *)(p->data + 8))) {
+            if (!game_create_subdirectory_for_file(game->menu.data_directory, (const char *)(data + 8))) {
                 fprintf(ERROR_FILE, "game_player_apply_message: Unable to create folder!\n");
                 return false;
             }
@@ -197,6 +259,9 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
             fprintf(INFO_FILE, "Received '%s' (%ld bytes).\n", game->client_recv_file, ftell(game->client_recv_fid));
             fclose(game->client_recv_fid);
             game->client_recv_fid = NULL;
+
+            //Keep a copy such that the file does not need to be sent again.
+            game_cache_file(game, game->client_recv_file);
             free(game->client_recv_file);
             game->client_recv_file = NULL;
             break;
@@ -207,16 +272,22 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
                 return false;
             }
             
-            if (*(uint32_t *)(p->data + 8) != (uint32_t)ftell(game->client_recv_fid)) {
+            if (*(const uint32_t *)(data + 8) != (uint32_t)ftell(game->client_recv_fid)) {
                 fprintf(ERROR_FILE, "game_player_apply_message: Unexpected file data offset!\n");
                 return false;
             }
 
-            if (*(uint32_t *)(p->data + 12) != fwrite(p->data + 16, 1, *(uint32_t *)(p->data + 12), game->client_recv_fid)) {
+            if (*(const uint32_t *)(data + 12) != fwrite(data + 16, 1, *(const uint32_t *)(data + 12), game->client_recv_fid)) {
                 fprintf(ERROR_FILE, "game_player_apply_message: Unable to write file data!\n");
                 return false;
             }
             break;
+        case RETRO_GAUNTLET_MSG_MANIFEST:
+            //Report which of the offered files we do not have.
+            return game_client_apply_manifest(game, data, nr_data);
+        case RETRO_GAUNTLET_MSG_MISSING:
+            //Send the files a player does not have.
+            return game_host_queue_missing_files(game, p, data, nr_data);
         default:
             fprintf(WARN_FILE, "game_player_apply_message: Unknown message type %u!\n", msg_type);
             break;
@@ -225,16 +296,19 @@ bool game_player_apply_message(struct gauntlet_game *game, struct gauntlet_playe
     return true;
 }
 
-bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_player *p, void *c) {
-    if (!p || !c || !game) {
-        fprintf(ERROR_FILE, "game_player_append_client_data: Invalid game, player, or client!\n");
+//Whether the player has received a complete message.
+static bool player_has_message(const struct gauntlet_player *p) {
+    return (p->nr_data_expected > 0 && p->nr_data == p->nr_data_expected);
+}
+
+//Read and decrypt data from a client until a message is complete, leaving the remaining data in the client's buffer.
+bool game_player_read_client_data(const struct blowfish *b, struct gauntlet_player *p, void *c) {
+    if (!b || !p || !c) {
+        fprintf(ERROR_FILE, "game_player_read_client_data: Invalid blowfish, player, or client!\n");
         return false;
     }
 
-    const struct blowfish *b = &game->fish;
-    
-    //We want to process all data in the client's buffer.
-    while (client_get_nr_data(c) > 0) {
+    while (!player_has_message(p) && client_get_nr_data(c) > 0) {
         if (p->nr_data_expected == 0) {
             //Try to complete the header of 8 bytes.
             p->nr_data += client_get_data(p->data + p->nr_data, c, 8u - p->nr_data);
@@ -245,14 +319,14 @@ bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_
                 blowfish_decrypt(b, (uint32_t *)(p->data + 0), (uint32_t *)(p->data + 4));
 
                 if (*(uint16_t *)(p->data + 0) != RETRO_GAUNTLET_NET_HEADER) {
-                    fprintf(ERROR_FILE, "player_append_client_data: Invalid header for network data from ");
+                    fprintf(ERROR_FILE, "player_read_client_data: Invalid header for network data from ");
                     client_fprintf(ERROR_FILE, c);
                     fprintf(ERROR_FILE, "!\n");
                     return false;
                 }
                 
                 if (*(uint16_t *)(p->data + 2) >= RETRO_GAUNTLET_MSG_MAX) {
-                    fprintf(ERROR_FILE, "player_append_client_data: Invalid network message type from ");
+                    fprintf(ERROR_FILE, "player_read_client_data: Invalid network message type from ");
                     client_fprintf(ERROR_FILE, c);
                     fprintf(ERROR_FILE, "!\n");
                     return false;
@@ -264,9 +338,10 @@ bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_
                 if (p->nr_data_expected >= MAX_RETRO_GAUNTLET_MSG_DATA ||
                     p->nr_data_expected < 8 ||
                     (p->nr_data_expected & 7) != 0) {
-                    fprintf(ERROR_FILE, "player_append_client_data: Invalid data size %zu from ", p->nr_data_expected);
+                    fprintf(ERROR_FILE, "player_read_client_data: Invalid data size %zu from ", p->nr_data_expected);
                     client_fprintf(ERROR_FILE, c);
                     fprintf(ERROR_FILE, "!\n");
+                    p->nr_data_expected = 0;
                     return false;
                 }
             }
@@ -275,30 +350,42 @@ bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_
             //Collect the expected data after the header.
             p->nr_data += client_get_data(p->data + p->nr_data, c, p->nr_data_expected - p->nr_data);
             assert(p->nr_data <= p->nr_data_expected);
+        }
 
-            if (p->nr_data == p->nr_data_expected) {
-                //We have the data that we need, so decrypt it (skipping the header).
-                for (size_t i = 8; i < p->nr_data; i += 8) {
-                    blowfish_decrypt(b, (uint32_t *)(p->data + i), (uint32_t *)(p->data + i + 4));
-                }
+        if (player_has_message(p)) {
+            //We have the data that we need, so decrypt it in place (skipping the header).
+            for (size_t i = 8; i < p->nr_data; i += 8) {
+                blowfish_decrypt(b, (uint32_t *)(p->data + i), (uint32_t *)(p->data + i + 4));
+            }
+        }
+    }
+    
+    return true;
+}
 
-                //Zero any remaining data from previous messages.
-                memset(p->data + p->nr_data, 0, MAX_RETRO_GAUNTLET_MSG_DATA - p->nr_data);
-                
-                //Apply message.
-                if (!game_player_apply_message(game, p)) {
-                    fprintf(ERROR_FILE, "player_append_client_data: Unable to apply message from ");
-                    client_fprintf(ERROR_FILE, c);
-                    fprintf(ERROR_FILE, "!\n");
-                    p->nr_data = 0;
-                    p->nr_data_expected = 0;
-                    return false;
-                }
+bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_player *p, void *c) {
+    if (!p || !c || !game) {
+        fprintf(ERROR_FILE, "game_player_append_client_data: Invalid game, player, or client!\n");
+        return false;
+    }
+
+    //We want to process all data in the client's buffer.
+    while (client_get_nr_data(c) > 0) {
+        if (!game_player_read_client_data(&game->fish, p, c)) return false;
 
-                //Data is no longer necessary.
-                memset(p->data, 0, MAX_RETRO_GAUNTLET_MSG_DATA);
-                p->nr_data = 0;
-                p->nr_data_expected = 0;
+        if (player_has_message(p)) {
+            //Apply message.
+            const bool ok = game_player_apply_message(game, p, p->data, p->nr_data);
+
+            //Data is no longer necessary.
+            p->nr_data = 0;
+            p->nr_data_expected = 0;
+
+            if (!ok) {
+                fprintf(ERROR_FILE, "player_append_client_data: Unable to apply message from ");
+                client_fprintf(ERROR_FILE, c);
+                fprintf(ERROR_FILE, "!\n");
+                return false;
             }
         }
     }
@@ -306,6 +393,208 @@ bool game_player_append_client_data(struct gauntlet_game *game, struct gauntlet_
     return true;
 }
 
+//Wake up the game thread, which may be waiting for input in the menu.
+static void game_wake_up(void) {
+    SDL_Event event;
+
+    memset(&event, 0, sizeof(SDL_Event));
+    event.type = SDL_USEREVENT;
+    SDL_PushEvent(&event);
+}
+
+static bool create_message_queue(struct gauntlet_message_queue *q, const size_t nr_bytes) {
+    memset(q, 0, sizeof(struct gauntlet_message_queue));
+
+    if (!create_audio_ring(&q->ring, nr_bytes)) return false;
+
+    if (!(q->room = SDL_CreateSemaphore(0))) {
+        fprintf(ERROR_FILE, "create_message_queue: Unable to create semaphore: %s!\n", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+static void free_message_queue(struct gauntlet_message_queue *q) {
+    free_audio_ring(&q->ring);
+    if (q->room) SDL_DestroySemaphore(q->room);
+
+    memset(q, 0, sizeof(struct gauntlet_message_queue));
+}
+
+//Discard all queued messages, only call when the network thread is not running.
+static void message_queue_clear(struct gauntlet_message_queue *q) {
+    audio_ring_clear(&q->ring);
+    while (q->room && SDL_SemTryWait(q->room) == 0) {}
+    SDL_AtomicSet(&q->waiting, 0);
+}
+
+//Number of queued bytes, safe to call from any thread.
+static size_t message_queue_available(struct gauntlet_message_queue *q) {
+    return audio_ring_available(&q->ring);
+}
+
+static size_t message_queue_get_nr_free(struct gauntlet_message_queue *q) {
+    return q->ring.nr_bytes - message_queue_available(q);
+}
+
+//Called by the network thread only, returns whether a message of the given size fits, waiting at most the time out for space.
+static bool message_queue_wait_for_room(struct gauntlet_message_queue *q, const size_t nr_bytes, const uint32_t time_out_ms) {
+    if (message_queue_get_nr_free(q) >= nr_bytes) return true;
+
+    //Check again after announcing that we wait, such that space released in between is not missed.
+    SDL_AtomicSet(&q->waiting, 1);
+    if (message_queue_get_nr_free(q) < nr_bytes) SDL_SemWaitTimeout(q->room, time_out_ms);
+    SDL_AtomicSet(&q->waiting, 0);
+
+    return message_queue_get_nr_free(q) >= nr_bytes;
+}
+
+//Called by the network thread only, after message_queue_wait_for_room().
+static void message_queue_write(struct gauntlet_message_queue *q, const void *data, const size_t nr_bytes) {
+    audio_ring_write(&q->ring, data, nr_bytes);
+}
+
+//Called by the game thread only, wakes the network thread if it waits for space.
+static void message_queue_released(struct gauntlet_message_queue *q) {
+    if (SDL_AtomicCAS(&q->waiting, 1, 0)) SDL_SemPost(q->room);
+}
+
+static size_t message_queue_peek(struct gauntlet_message_queue *q, const uint8_t **data) {
+    return audio_ring_peek(&q->ring, data);
+}
+
+static void message_queue_read(struct gauntlet_message_queue *q, void *data, const size_t nr_bytes) {
+    audio_ring_read(&q->ring, data, nr_bytes);
+    message_queue_released(q);
+}
+
+static void message_queue_skip(struct gauntlet_message_queue *q, const size_t nr_bytes) {
+    audio_ring_skip(&q->ring, nr_bytes);
+    message_queue_released(q);
+}
+
+//Receive and decrypt messages from the host, such that networking continues while a core is running.
+static int game_client_thread(void *data) {
+    struct gauntlet_game *game = (struct gauntlet_game *)data;
+    struct gauntlet_player *p = &game->client_reader;
+    struct gauntlet_message_queue *messages = &game->client_messages;
+    bool ok = true;
+
+    while (ok && SDL_AtomicGet(&game->client_quit) == 0) {
+        if (player_has_message(p)) {
+            //Pass on the complete message, leaving data in the socket while the game thread catches up.
+            if (!message_queue_wait_for_room(messages, p->nr_data, RETRO_GAUNTLET_CLIENT_WAIT_MS)) continue;
+
+            const size_t nr_queued = message_queue_available(messages);
+
+            message_queue_write(messages, p->data, p->nr_data);
+            p->nr_data = 0;
+            p->nr_data_expected = 0;
+
+            if (nr_queued == 0) game_wake_up();
+            continue;
+        }
+
+        //Only this thread receives, so waiting does not need the lock and leaves the game thread free to send.
+        if (client_get_nr_data(game->client) == 0 && !client_wait(game->client, RETRO_GAUNTLET_CLIENT_WAIT_MS)) continue;
+
+        SDL_LockMutex(game->client_mutex);
+        if (client_get_nr_data(game->client) == 0) ok = client_listen(game->client, 0);
+        if (ok) ok = game_player_read_client_data(&game->fish, p, game->client);
+        SDL_UnlockMutex(game->client_mutex);
+    }
+
+    SDL_AtomicSet(&game->client_active, 0);
+    game_wake_up();
+
+    return 0;
+}
+
+static bool game_start_client_thread(struct gauntlet_game *game) {
+    if (!game || game->client_thread) {
+        fprintf(ERROR_FILE, "game_start_client_thread: Invalid game or thread already running!\n");
+        return false;
+    }
+
+    create_player(&game->client_reader);
+    message_queue_clear(&game->client_messages);
+    SDL_AtomicSet(&game->client_quit, 0);
+    SDL_AtomicSet(&game->client_active, 1);
+
+    if (!(game->client_thread = SDL_CreateThread(game_client_thread, "client", game))) {
+        fprintf(ERROR_FILE, "game_start_client_thread: Unable to create thread: %s!\n", SDL_GetError());
+        SDL_AtomicSet(&game->client_active, 0);
+        return false;
+    }
+
+    return true;
+}
+
+static void game_stop_client_thread(struct gauntlet_game *game) {
+    if (!game->client_thread) return;
+
+    SDL_AtomicSet(&game->client_quit, 1);
+    SDL_WaitThread(game->client_thread, NULL);
+    game->client_thread = NULL;
+    SDL_AtomicSet(&game->client_active, 0);
+
+    //Discard messages that were not applied.
+    message_queue_clear(&game->client_messages);
+    game->nr_deferred_messages = 0;
+    game->players[0].nr_data = 0;
+    game->players[0].nr_data_expected = 0;
+}
+
+//Wait for network activity while the game thread waits for input, as SDL cannot wait for sockets.
+static int game_host_thread(void *data) {
+    struct gauntlet_game *game = (struct gauntlet_game *)data;
+
+    while (true) {
+        SDL_SemWait(game->host_wait_start);
+
+        if (SDL_AtomicGet(&game->host_quit)) break;
+
+        //The game thread does not touch the host until we are done waiting.
+        bool active = false;
+
+        while (!active && SDL_AtomicGet(&game->host_waiting)) active = host_wait(game->host, RETRO_GAUNTLET_MENU_WAIT_MS);
+
+        if (active) game_wake_up();
+
+        SDL_SemPost(game->host_wait_done);
+    }
+
+    return 0;
+}
+
+static bool game_start_host_thread(struct gauntlet_game *game) {
+    if (!game || game->host_thread) {
+        fprintf(ERROR_FILE, "game_start_host_thread: Invalid game or thread already running!\n");
+        return false;
+    }
+
+    SDL_AtomicSet(&game->host_quit, 0);
+    SDL_AtomicSet(&game->host_waiting, 0);
+
+    if (!(game->host_thread = SDL_CreateThread(game_host_thread, "host", game))) {
+        fprintf(ERROR_FILE, "game_start_host_thread: Unable to create thread: %s!\n", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+static void game_stop_host_thread(struct gauntlet_game *game) {
+    if (!game->host_thread) return;
+
+    //The thread is waiting for us to start waiting, as we only call this outside of game_wait_for_menu_event().
+    SDL_AtomicSet(&game->host_quit, 1);
+    SDL_SemPost(game->host_wait_start);
+    SDL_WaitThread(game->host_thread, NULL);
+    game->host_thread = NULL;
+}
+
 size_t net_message_package(uint8_t *data, size_t nr_data, const uint16_t msg_type, const struct blowfish *b) {
     //Assumes data is an array of MAX_RETRO_GAUNTLET_MSG_DATA bytes.
     if (!b || !data) {
@@ -322,11 +611,11 @@ size_t net_message_package(uint8_t *data, size_t nr_data, const uint16_t msg_typ
     memmove(data + 8, data, nr_data);
     nr_data += 8;
 
-    //Zero data tail.
-    memset(data + nr_data, 0, MAX_RETRO_GAUNTLET_MSG_DATA - nr_data);
+    //Make the amount of data a multiple of 8, zeroing the padding.
+    const size_t nr_padded = (((nr_data - 1) >> 3) + 1) << 3;
 
-    //Make the amount of data a multiple of 8.
-    nr_data = (((nr_data - 1) >> 3) + 1) << 3;
+    memset(data + nr_data, 0, nr_padded - nr_data);
+    nr_data = nr_padded;
     
     //Setup header.
     *(uint16_t *)(data + 0) = RETRO_GAUNTLET_NET_HEADER;
@@ -372,7 +661,7 @@ size_t game_create_net_message_start(struct gauntlet_game *game, const char *ini
     return net_message_package(game->message_buffer, strlen((char *)game->message_buffer) + 1, RETRO_GAUNTLET_MSG_START, &game->fish);
 }
 
-size_t game_create_net_message_finish(struct gauntlet_game *game, const uint32_t status, const uint32_t time) {
+size_t game_create_net_message_finish(struct gauntlet_game *game, const uint32_t status, const uint32_t time, const uint32_t wall_time) {
     if (!game) {
         fprintf(ERROR_FILE, "game_create_net_message_finish: Invalid game!\n");
         return 0;
@@ -380,7 +669,8 @@ size_t game_create_net_message_finish(struct gauntlet_game *game, const uint32_t
     
     *(uint32_t *)(game->message_buffer + 0) = status;
     *(uint32_t *)(game->message_buffer + 4) = time;
-    return net_message_package(game->message_buffer, 8, RETRO_GAUNTLET_MSG_FINISH, &game->fish);
+    *(uint32_t *)(game->message_buffer + 8) = wall_time;
+    return net_message_package(game->message_buffer, 12, RETRO_GAUNTLET_MSG_FINISH, &game->fish);
 }
 
 size_t game_create_net_message_get_files(struct gauntlet_game *game) {
@@ -461,62 +751,331 @@ bool game_expand_path_and_file_name(char **full_path_p, char **full_file_p, cons
     return true;
 }
 
-bool game_host_broadcast_file(struct gauntlet_game *game, const char *file) {
+//Send the next part of the files a client is missing, keeping at most RETRO_GAUNTLET_SYNC_QUEUE_SIZE bytes queued for it.
+static bool game_host_send_sync_file_data(struct gauntlet_game *game, const int i_client) {
+    struct gauntlet_player *p = &game->players[i_client + 1];
+    void *client = host_get_client(game->host, i_client);
+    bool ok = (client != NULL);
+
+    while (ok && p->sync_missing != 0 && host_get_nr_queued(game->host, client) < RETRO_GAUNTLET_SYNC_QUEUE_SIZE) {
+        //Send missing files in order.
+        size_t j = 0;
+
+        while (!(p->sync_missing & (1u << j))) ++j;
+
+        const struct gauntlet_sync_file *f = &game->sync_files[j];
+        FILE *fid = fopen(f->file, "rb");
+
+        if (!fid || fseek(fid, (long)p->sync_offset, SEEK_SET) != 0) {
+            fprintf(ERROR_FILE, "game_host_send_sync_file_data: Unable to open '%s' for reading!\n", f->file);
+            if (fid) fclose(fid);
+            return false;
+        }
+
+        if (p->sync_offset == 0) ok = host_send(game->host, client, game->message_buffer, game_create_net_message_file_start(game, f->name));
+
+        //Read and send data until the client's queue is full or the file is done.
+        uint8_t buffer[NR_RETRO_NET_FILE_DATA];
+        size_t len = 0;
+
+        do {
+            len = fread(buffer, 1, NR_RETRO_NET_FILE_DATA, fid);
+            if (len > 0) ok = ok && host_send(game->host, client, game->message_buffer, game_create_net_message_file_data(game, p->sync_offset, len, buffer));
+            p->sync_offset += len;
+        } while (ok && len == NR_RETRO_NET_FILE_DATA && host_get_nr_queued(game->host, client) < RETRO_GAUNTLET_SYNC_QUEUE_SIZE);
+
+        if (ferror(fid)) ok = false;
+        fclose(fid);
+
+        if (ok && len < NR_RETRO_NET_FILE_DATA) {
+            ok = host_send(game->host, client, game->message_buffer, game_create_net_message_file_end(game, f->name));
+
+            if (ok) {
+                fprintf(INFO_FILE, "Sent '%s' (%zu bytes) to ", f->name, p->sync_offset);
+                client_fprintf(INFO_FILE, client);
+                fprintf(INFO_FILE, ".\n");
+            }
+
+            p->sync_missing &= ~(1u << j);
+            p->sync_offset = 0;
+        }
+
+        if (!ok) fprintf(ERROR_FILE, "game_host_send_sync_file_data: Unable to send '%s'!\n", f->name);
+
+        p->sync_time = SDL_GetTicks();
+    }
+
+    return ok;
+}
+
+size_t game_create_net_message_manifest(struct gauntlet_game *game) {
+    if (!game) {
+        fprintf(ERROR_FILE, "game_create_net_message_manifest: Invalid game!\n");
+        return 0;
+    }
+
+    //List the hash, size, and name of each file.
+    size_t nr_data = 4;
+
+    for (size_t i = 0; i < game->nr_sync_files; ++i) {
+        const struct gauntlet_sync_file *f = &game->sync_files[i];
+        const size_t len = strlen(f->name) + 1;
+
+        if (nr_data + 12 + len + 8 > MAX_RETRO_GAUNTLET_MSG_DATA) {
+            fprintf(ERROR_FILE, "game_create_net_message_manifest: Too many files!\n");
+            return 0;
+        }
+
+        memcpy(game->message_buffer + nr_data, &f->hash, 8);
+        memcpy(game->message_buffer + nr_data + 8, &f->size, 4);
+        memcpy(game->message_buffer + nr_data + 12, f->name, len);
+        nr_data += 12 + len;
+    }
+
+    *(uint32_t *)(game->message_buffer + 0) = game->nr_sync_files;
+    return net_message_package(game->message_buffer, nr_data, RETRO_GAUNTLET_MSG_MANIFEST, &game->fish);
+}
+
+size_t game_create_net_message_missing(struct gauntlet_game *game, const uint64_t *hashes, const size_t nr_hashes) {
+    if (!game || (!hashes && nr_hashes > 0)) {
+        fprintf(ERROR_FILE, "game_create_net_message_missing: Invalid game or hashes!\n");
+        return 0;
+    }
+
+    if (4 + 8*nr_hashes + 8 > MAX_RETRO_GAUNTLET_MSG_DATA) {
+        fprintf(ERROR_FILE, "game_create_net_message_missing: Too many files!\n");
+        return 0;
+    }
+
+    *(uint32_t *)(game->message_buffer + 0) = nr_hashes;
+    if (nr_hashes > 0) memcpy(game->message_buffer + 4, hashes, 8*nr_hashes);
+    return net_message_package(game->message_buffer, 4 + 8*nr_hashes, RETRO_GAUNTLET_MSG_MISSING, &game->fish);
+}
+
+//Get the name of a file in the local cache from its content hash.
+static char *game_get_cache_file(struct gauntlet_game *game, const uint64_t hash) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s/%016llx", RETRO_GAUNTLET_CACHE_DIRECTORY, (unsigned long long)hash);
+
+    return combine_paths(game->menu.data_directory, name);
+}
+
+//Store a copy of a file in the local cache, named after its content hash.
+bool game_cache_file(struct gauntlet_game *game, const char *file) {
     if (!game || !file) {
-        fprintf(ERROR_FILE, "game_host_broadcast_file: Invalid game or file!\n");
+        fprintf(ERROR_FILE, "game_cache_file: Invalid game or file!\n");
         return false;
     }
-    
-    if (!host_is_host_active(game->host)) {
-        fprintf(ERROR_FILE, "game_host_broadcast_file: Host is not running!\n");
+
+    uint64_t hash;
+    size_t size;
+
+    if (!hash_file(file, &hash, &size)) {
+        fprintf(ERROR_FILE, "game_cache_file: Unable to read '%s'!\n", file);
         return false;
     }
-    
+
+    char *cache_directory = combine_paths(game->menu.data_directory, RETRO_GAUNTLET_CACHE_DIRECTORY);
+    char *cache_file = game_get_cache_file(game, hash);
+    bool ok = (cache_directory && cache_file && create_directory(cache_directory));
+
+    //Replace damaged cache entries, otherwise the file would be transferred again at every start.
+    uint64_t cache_hash;
+    size_t cache_size;
+
+    if (ok && !(hash_file(cache_file, &cache_hash, &cache_size) && cache_hash == hash && cache_size == size)) ok = copy_file(cache_file, file);
+    if (!ok) fprintf(ERROR_FILE, "game_cache_file: Unable to cache '%s'!\n", file);
+
+    if (cache_directory) free(cache_directory);
+    if (cache_file) free(cache_file);
+
+    return ok;
+}
+
+//Check whether we have a file with the given contents, restoring it from the cache if necessary.
+static bool game_client_has_file(struct gauntlet_game *game, const char *file, const uint64_t hash, const uint32_t size) {
+    char *local_file = combine_paths(game->menu.data_directory, file);
+    uint64_t local_hash;
+    size_t local_size;
+
+    if (!local_file) return false;
+
+    bool found = (hash_file(local_file, &local_hash, &local_size) && local_hash == hash && local_size == size);
+
+    if (!found) {
+        char *cache_file = game_get_cache_file(game, hash);
+
+        //Verify the cached copy, such that a damaged cache only costs a transfer.
+        found = (cache_file && hash_file(cache_file, &local_hash, &local_size) && local_hash == hash && local_size == size &&
+                 game_create_subdirectory_for_file(game->menu.data_directory, file) && copy_file(local_file, cache_file));
+
+        if (found) fprintf(INFO_FILE, "Restored '%s' from the cache.\n", local_file);
+        if (cache_file) free(cache_file);
+    }
+
+    free(local_file);
+
+    return found;
+}
+
+bool game_client_apply_manifest(struct gauntlet_game *game, const uint8_t *data, const size_t nr_data) {
+    if (!game || !data || nr_data < 12) {
+        fprintf(ERROR_FILE, "game_client_apply_manifest: Invalid game or manifest!\n");
+        return false;
+    }
+
+    //Each file takes at least 13 bytes.
+    uint32_t nr_files;
+
+    memcpy(&nr_files, data + 8, 4);
+
+    if (nr_files > (nr_data - 12)/13) {
+        fprintf(ERROR_FILE, "game_client_apply_manifest: Invalid number of files %u!\n", nr_files);
+        return false;
+    }
+
+    //Get ready to receive files, change sockets to blocking.
+    game_draw_message_to_screen(game, "Synchronizing data with host...");
+    game_client_set_blocking(game, true);
+
+    uint64_t *missing = (uint64_t *)malloc(8*(size_t)max(nr_files, 1u));
+    size_t nr_missing = 0;
+    size_t offset = 12;
+
+    if (!missing) {
+        fprintf(ERROR_FILE, "game_client_apply_manifest: Insufficient memory!\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < nr_files; ++i) {
+        uint64_t hash;
+        uint32_t size;
+        const char *file = (const char *)(data + offset + 12);
+        const char *end = (offset + 12 < nr_data ? (const char *)memchr(file, 0, nr_data - offset - 12) : NULL);
+
+        if (!end) {
+            fprintf(ERROR_FILE, "game_client_apply_manifest: Manifest is truncated!\n");
+            free(missing);
+            return false;
+        }
+
+        memcpy(&hash, data + offset, 8);
+        memcpy(&size, data + offset + 8, 4);
+        offset = (size_t)((const uint8_t *)end - data) + 1;
+
+        if (!game_client_has_file(game, file, hash, size)) missing[nr_missing++] = hash;
+    }
+
+    fprintf(INFO_FILE, "Requesting %zu of %u files from host.\n", nr_missing, nr_files);
+
+    const bool ok = game_client_send(game, game->message_buffer, game_create_net_message_missing(game, missing, nr_missing));
+
+    free(missing);
+
+    return ok;
+}
+
+bool game_host_queue_missing_files(struct gauntlet_game *game, struct gauntlet_player *p, const uint8_t *data, const size_t nr_data) {
+    if (!game || !p || !data || nr_data < 12 || !host_is_host_active(game->host)) {
+        fprintf(ERROR_FILE, "game_host_queue_missing_files: Invalid game, player, or message!\n");
+        return false;
+    }
+
+    uint32_t nr_hashes;
+
+    memcpy(&nr_hashes, data + 8, 4);
+
+    //Files are only sent before the gauntlet starts.
+    if (!p->sync_pending) {
+        fprintf(WARN_FILE, "game_host_queue_missing_files: Ignoring late file request from player %s!\n", p->name);
+        return true;
+    }
+
+    p->sync_pending = false;
+    p->sync_missing = 0;
+    p->sync_offset = 0;
+    p->sync_time = SDL_GetTicks();
+    fprintf(INFO_FILE, "Player %s is missing %u of %zu files.\n", p->name, nr_hashes, game->nr_sync_files);
+
+    for (uint32_t i = 0; i < nr_hashes; ++i) {
+        uint64_t hash;
+        size_t j = 0;
+
+        memcpy(&hash, data + 12 + 8*i, 8);
+
+        while (j < game->nr_sync_files && game->sync_files[j].hash != hash) ++j;
+
+        if (j >= game->nr_sync_files) {
+            fprintf(WARN_FILE, "game_host_queue_missing_files: Player %s requested unknown file %016llx!\n", p->name, (unsigned long long)hash);
+            continue;
+        }
+
+        p->sync_missing |= (1u << j);
+    }
+
+    return true;
+}
+
+//Add a file to the manifest offered to clients.
+bool game_host_add_sync_file(struct gauntlet_game *game, const char *file) {
+    if (!game || !file) {
+        fprintf(ERROR_FILE, "game_host_add_sync_file: Invalid game or file!\n");
+        return false;
+    }
+
     //Expand to full path, resolve symlinks.
     char *data_directory, *full_file;
     
     if (!game_expand_path_and_file_name(&data_directory, &full_file, game->menu.data_directory, file)) return false;
-    
-    //Open file for reading.
-    FILE *fid = fopen(full_file, "rb");
-    bool ok = true;
 
-    if (!fid) {
-        fprintf(ERROR_FILE, "game_host_broadcast_file: Unable to open '%s' for reading!\n", full_file);
+    if (game->nr_sync_files >= MAX_RETRO_GAUNTLET_SYNC_FILES) {
+        fprintf(ERROR_FILE, "game_host_add_sync_file: Too many files!\n");
         free(full_file);
         free(data_directory);
         return false;
     }
-    
-    ok = ok && host_broadcast(game->host, game->message_buffer, game_create_net_message_file_start(game, full_file + strlen(data_directory) + 1));
-    
-    //Read and broadcast data.
-    uint8_t buffer[NR_RETRO_NET_FILE_DATA];
-    size_t offset = 0;
-    size_t len = 0;
 
-    while ((len = fread(buffer, 1, NR_RETRO_NET_FILE_DATA, fid)) > 0) {
-        ok = ok && host_broadcast(game->host, game->message_buffer, game_create_net_message_file_data(game, offset, len, buffer));
-        offset += len;
-    }
+    struct gauntlet_sync_file f;
+    size_t size;
+    bool ok = hash_file(full_file, &f.hash, &size);
 
-    ok = ok && host_broadcast(game->host, game->message_buffer, game_create_net_message_file_end(game, full_file + strlen(data_directory) + 1));
-    
-    //Clean up.
-    fclose(fid);
-    free(full_file);
+    if (!ok) fprintf(ERROR_FILE, "game_host_add_sync_file: Unable to read '%s'!\n", full_file);
+
+    f.size = size;
+    f.file = full_file;
+    f.name = full_file + strlen(data_directory) + 1;
     free(data_directory);
-    
+
     if (!ok) {
-        fprintf(ERROR_FILE, "game_host_broadcast_file: Unable to broadcast '%s'!\n", full_file);
+        free(full_file);
         return false;
     }
 
-    fprintf(INFO_FILE, "Broadcasted '%s' (%zu bytes) to clients.\n", file, offset);
+    struct gauntlet_sync_file *sync_files = (struct gauntlet_sync_file *)realloc(game->sync_files, (game->nr_sync_files + 1)*sizeof(struct gauntlet_sync_file));
+
+    if (!sync_files) {
+        fprintf(ERROR_FILE, "game_host_add_sync_file: Insufficient memory!\n");
+        free(f.file);
+        return false;
+    }
+
+    game->sync_files = sync_files;
+    game->sync_files[game->nr_sync_files++] = f;
 
     return true;
 }
 
+void game_clear_sync_files(struct gauntlet_game *game) {
+    if (!game) return;
+
+    for (size_t i = 0; i < game->nr_sync_files; ++i) free(game->sync_files[i].file);
+    if (game->sync_files) free(game->sync_files);
+
+    game->sync_files = NULL;
+    game->nr_sync_files = 0;
+}
+
 void game_draw_message_to_screen(struct gauntlet_game *game, const char *format, ...) {
     if (!game || !format) return;
 
@@ -529,7 +1088,6 @@ void game_draw_message_to_screen(struct gauntlet_game *game, const char *format,
     fprintf(INFO_FILE, "%s\n", game->menu.text);
     
     menu_draw(&game->menu);
-    video_refresh_from_sdl_surface(&game->menu.video, game->menu.surface);
     video_render(&game->menu.video);
     SDL_GL_SwapWindow(game->window);
 }
@@ -579,7 +1137,12 @@ bool create_game(struct gauntlet_game *game, const char *data_directory, SDL_Win
 
     //Setup network.
     allocate_clients(&game->client, 1);
-    for (size_t i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) create_player(&game->players[i]);
+
+    if (!game_reserve_players(game, 1)) {
+        fprintf(ERROR_FILE, "create_game: Unable to create player!\n");
+        return false;
+    }
+
     strcpy(game->players[0].name, game->menu.player_name);
 
     if (!create_blowfish(&game->fish, (uint8_t *)game->menu.password, strlen(game->menu.password))) {
@@ -589,9 +1152,31 @@ bool create_game(struct gauntlet_game *game, const char *data_directory, SDL_Win
 
     SDL_Delay(100);
     game->menu.state = RETRO_GAUNTLET_STATE_SELECT_GAUNTLET;
+    game->menu_changed = true;
     
-    game->start_ticks = 0;
-    game->nr_frames = 0;
+    create_frame_pacer(&game->pacer, game->menu.frame_pacing, game->menu.max_frame_skip);
+    create_frame_pacer(&game->emulation_pacer, FRAME_PACER_FREE_RUN, game->menu.max_frame_skip);
+
+    if (!(game->emulation_mutex = SDL_CreateMutex())) {
+        fprintf(ERROR_FILE, "create_game: Unable to create emulation mutex: %s!\n", SDL_GetError());
+        return false;
+    }
+
+    if (!(game->client_mutex = SDL_CreateMutex())) {
+        fprintf(ERROR_FILE, "create_game: Unable to create client mutex: %s!\n", SDL_GetError());
+        return false;
+    }
+
+    if (!create_message_queue(&game->client_messages, RETRO_GAUNTLET_CLIENT_QUEUE_SIZE)) {
+        fprintf(ERROR_FILE, "create_game: Unable to create client message queue!\n");
+        return false;
+    }
+
+    if (!(game->host_wait_start = SDL_CreateSemaphore(0)) || !(game->host_wait_done = SDL_CreateSemaphore(0))) {
+        fprintf(ERROR_FILE, "create_game: Unable to create host semaphores: %s!\n", SDL_GetError());
+        return false;
+    }
+
     game->fullscreen = false;
     game->keep_running = true;
 
@@ -608,9 +1193,17 @@ bool free_game(struct gauntlet_game *game) {
     game_stop_gauntlet(game);
 
     //Free networking.
+    game_stop_client_thread(game);
+    game_stop_host_thread(game);
     if (game->host) free_host(&game->host);
     if (game->client) free_clients(&game->client, 1);
     free_blowfish(&game->fish);
+    free_message_queue(&game->client_messages);
+    if (game->deferred_messages) free(game->deferred_messages);
+    game->deferred_messages = NULL;
+    game->nr_deferred_messages = 0;
+    game->max_deferred_messages = 0;
+    game_clear_sync_files(game);
 
     //Free menu.
     menu_stop_mixer(&game->menu);
@@ -624,6 +1217,13 @@ bool free_game(struct gauntlet_game *game) {
         free(game->gauntlets);
     }
 
+    if (game->emulation_mutex) SDL_DestroyMutex(game->emulation_mutex);
+    if (game->client_mutex) SDL_DestroyMutex(game->client_mutex);
+    if (game->host_wait_start) SDL_DestroySemaphore(game->host_wait_start);
+    if (game->host_wait_done) SDL_DestroySemaphore(game->host_wait_done);
+    if (game->players) free(game->players);
+    if (game->player_indices) free(game->player_indices);
+
     memset(game, 0, sizeof(struct gauntlet_game));
 
     return true;
@@ -642,8 +1242,11 @@ bool game_start_host(struct gauntlet_game *game) {
     strcpy(game->players[0].name, game->menu.player_name);
 
     strcpy(game->lobby_text, "Waiting for lobby update...");
+    game->nr_lobby_clients = 0;
+    game->lobby_changed = true;
 
-    if (!allocate_host(&game->host, game->menu.network_port, MAX_RETRO_GAUNTLET_CLIENTS)) {
+    if (!allocate_host(&game->host, game->menu.network_port, MAX_RETRO_GAUNTLET_CLIENTS) || !game_start_host_thread(game)) {
+        if (game->host) free_host(&game->host);
         menu_draw_message(&game->menu, "Unable to host gauntlet!");
         return false;
     }
@@ -660,12 +1263,86 @@ bool game_stop_host(struct gauntlet_game *game) {
     }
     
     game_stop_gauntlet(game);
+    game_stop_host_thread(game);
     if (game->host) free_host(&game->host);
     game->menu.state = RETRO_GAUNTLET_STATE_SELECT_GAUNTLET;
 
     return true;
 }
 
+//Whether any client still has to report which files it is missing.
+static bool game_host_is_sync_pending(struct gauntlet_game *game) {
+    for (int i = host_get_active_client_index(game->host, 0); i >= 0; i = host_get_active_client_index(game->host, i + 1)) {
+        if (i + 1 < game->nr_players && game->players[i + 1].sync_pending) return true;
+    }
+
+    return false;
+}
+
+//Whether any client still has to receive files.
+static bool game_host_is_sync_sending(struct gauntlet_game *game) {
+    for (int i = host_get_active_client_index(game->host, 0); i >= 0; i = host_get_active_client_index(game->host, i + 1)) {
+        if (i + 1 < game->nr_players && game->players[i + 1].sync_missing != 0) return true;
+    }
+
+    return false;
+}
+
+//Stop syncing files with all players, such that no files are sent once the gauntlet starts.
+static void game_host_stop_sync(struct gauntlet_game *game) {
+    for (int i = 0; i < game->nr_players; ++i) {
+        game->players[i].sync_pending = false;
+        game->players[i].sync_missing = 0;
+        game->players[i].sync_offset = 0;
+    }
+}
+
+//Offer the sync files to all clients and send them the files they are missing, before the gauntlet starts.
+static bool game_host_sync_files(struct gauntlet_game *game) {
+    bool ok = true;
+
+    game_host_stop_sync(game);
+
+    if (game->nr_sync_files > 0) {
+        for (int i = host_get_active_client_index(game->host, 0); i >= 0; i = host_get_active_client_index(game->host, i + 1)) {
+            if (i + 1 < game->nr_players) game->players[i + 1].sync_pending = true;
+        }
+
+        ok = host_broadcast(game->host, game->message_buffer, game_create_net_message_manifest(game));
+
+        //Clients reply with the files they are missing, which are sent to them in parts without holding up the other replies.
+        const uint32_t start_time = SDL_GetTicks();
+
+        while (ok && (game_host_is_sync_pending(game) || game_host_is_sync_sending(game))) {
+            if (game_host_is_sync_pending(game) && SDL_GetTicks() - start_time > RETRO_GAUNTLET_SYNC_TIMEOUT_MS) {
+                fprintf(WARN_FILE, "game_host_sync_files: Not all clients reported their files in time!\n");
+
+                for (int i = 0; i < game->nr_players; ++i) game->players[i].sync_pending = false;
+            }
+
+            host_wait(game->host, RETRO_GAUNTLET_SYNC_WAIT_MS);
+            ok = game_update_host(game);
+
+            for (int i = host_get_active_client_index(game->host, 0); ok && i >= 0; i = host_get_active_client_index(game->host, i + 1)) {
+                struct gauntlet_player *p = &game->players[i + 1];
+
+                if (i + 1 >= game->nr_players || p->sync_missing == 0) continue;
+
+                //Drop clients we cannot send to, or that stopped receiving.
+                if (!game_host_send_sync_file_data(game, i) || SDL_GetTicks() - p->sync_time > RETRO_GAUNTLET_SYNC_TIMEOUT_MS) {
+                    fprintf(WARN_FILE, "game_host_sync_files: Dropping player %s as files cannot be sent to them!\n", p->name);
+                    if (host_is_client_active(game->host, i)) host_remove_client(game->host, i);
+                    p->sync_missing = 0;
+                }
+            }
+        }
+    }
+
+    game_host_stop_sync(game);
+
+    return ok;
+}
+
 bool game_host_start_gauntlet(struct gauntlet_game *game) {
     if (!game || !host_is_host_active(game->host)) {
         fprintf(ERROR_FILE, "game_host_start_gauntlet: Invalid game or host!\n");
@@ -673,12 +1350,15 @@ bool game_host_start_gauntlet(struct gauntlet_game *game) {
     }
 
     //Reset all player states.
-    for (size_t i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 0; i < game->nr_players; ++i) {
         game->players[i].finish_state = RETRO_GAUNTLET_RUNNING;
         game->players[i].finish_time = 0;
+        game->players[i].finish_wall_time = 0;
         game->players[i].last_points = 0;
     }
 
+    game->lobby_changed = true;
+
     struct gauntlet *g = &game->gauntlets[game->i_gauntlet];
 
     if (!g->ini_file || !g->win_condition_file) {
@@ -691,35 +1371,34 @@ bool game_host_start_gauntlet(struct gauntlet_game *game) {
 
     host_set_blocking(game->host, true);
     
-    if (!host_broadcast(game->host, game->message_buffer, game_create_net_message_get_files(game))) {
-        fprintf(ERROR_FILE, "game_host_start_gauntlet: Unable to broadcast get files!\n");
-        return false;
-    }
-
-    //Send file updates.
+    //Offer files to clients by content hash, such that only files they do not have are sent.
     bool ok = true;
+
+    game_clear_sync_files(game);
     
     if (game->menu.sync_level >= RETRO_GAUNTLET_SYNC_INI) {
-        if (ok) ok = ok && game_host_broadcast_file(game, g->ini_file);
-        if (ok && g->win_condition_file) ok = ok && game_host_broadcast_file(game, g->win_condition_file);
-        if (ok && g->lose_condition_file) ok = ok && game_host_broadcast_file(game, g->lose_condition_file);
-        if (ok && g->rom_startup_file) ok = ok && game_host_broadcast_file(game, g->rom_startup_file);
-        if (ok && g->core_variables_file) ok = ok && game_host_broadcast_file(game, g->core_variables_file);
+        if (ok) ok = ok && game_host_add_sync_file(game, g->ini_file);
+        if (ok && g->win_condition_file) ok = ok && game_host_add_sync_file(game, g->win_condition_file);
+        if (ok && g->lose_condition_file) ok = ok && game_host_add_sync_file(game, g->lose_condition_file);
+        if (ok && g->rom_startup_file) ok = ok && game_host_add_sync_file(game, g->rom_startup_file);
+        if (ok && g->core_variables_file) ok = ok && game_host_add_sync_file(game, g->core_variables_file);
         
         if (game->menu.sync_level >= RETRO_GAUNTLET_SYNC_SAVE) {
-            if (ok && g->core_save_file) ok = ok && game_host_broadcast_file(game, g->core_save_file);
+            if (ok && g->core_save_file) ok = ok && game_host_add_sync_file(game, g->core_save_file);
 
             if (game->menu.sync_level >= RETRO_GAUNTLET_SYNC_ROM) {
-                if (ok && g->rom_file) ok = ok && game_host_broadcast_file(game, g->rom_file);
+                if (ok && g->rom_file) ok = ok && game_host_add_sync_file(game, g->rom_file);
 
                 if (game->menu.sync_level >= RETRO_GAUNTLET_SYNC_ALL) {
-                    if (ok && g->core_library_file_win64) ok = ok && game_host_broadcast_file(game, g->core_library_file_win64);
-                    if (ok && g->core_library_file_linux64) ok = ok && game_host_broadcast_file(game, g->core_library_file_linux64);
+                    if (ok && g->core_library_file_win64) ok = ok && game_host_add_sync_file(game, g->core_library_file_win64);
+                    if (ok && g->core_library_file_linux64) ok = ok && game_host_add_sync_file(game, g->core_library_file_linux64);
                 }
             }
         }
     }
 
+    if (ok) ok = game_host_sync_files(game);
+
     if (!ok) {
         fprintf(ERROR_FILE, "game_host_start_gauntlet: Unable to sync files!\n");
         return false;
@@ -767,11 +1446,20 @@ bool game_update_host(struct gauntlet_game *game) {
     }
 
     int i = host_get_active_client_index(game->host, 0);
+    int nr_clients = 0;
 
     while (i >= 0) {
+        //Players are stored after the local player.
+        if (!game_reserve_players(game, i + 2)) {
+            host_remove_client(game->host, i);
+            i = host_get_active_client_index(game->host, i + 1);
+            continue;
+        }
+
         if (host_is_client_new(game->host, i)) {
             //A new player has joined.
             create_player(&game->players[i + 1]);
+            game->lobby_changed = true;
         }
 
         //Act on any data the clients provide.
@@ -780,6 +1468,13 @@ bool game_update_host(struct gauntlet_game *game) {
         }
 
         i = host_get_active_client_index(game->host, i + 1);
+        ++nr_clients;
+    }
+
+    //Players have left.
+    if (nr_clients != game->nr_lobby_clients) {
+        game->nr_lobby_clients = nr_clients;
+        game->lobby_changed = true;
     }
 
     return true;
@@ -799,6 +1494,44 @@ bool create_player(struct gauntlet_player *p) {
     return true;
 }
 
+//Make sure there are at least nr_players players, growing the player table geometrically.
+bool game_reserve_players(struct gauntlet_game *game, const int nr_players) {
+    if (!game || nr_players < 0) {
+        fprintf(ERROR_FILE, "game_reserve_players: Invalid game or number of players!\n");
+        return false;
+    }
+
+    if (nr_players <= game->nr_players) return true;
+
+    const int nr_new = max(nr_players, min(2*game->nr_players, MAX_RETRO_GAUNTLET_CLIENTS + 1));
+    struct gauntlet_player *players = (struct gauntlet_player *)realloc(game->players, nr_new*sizeof(struct gauntlet_player));
+
+    if (!players) {
+        fprintf(ERROR_FILE, "game_reserve_players: Unable to allocate %d players!\n", nr_new);
+        return false;
+    }
+
+    game->players = players;
+
+    int *player_indices = (int *)realloc(game->player_indices, nr_new*sizeof(int));
+
+    if (!player_indices) {
+        fprintf(ERROR_FILE, "game_reserve_players: Unable to allocate %d player indices!\n", nr_new);
+        return false;
+    }
+
+    game->player_indices = player_indices;
+
+    for (int i = game->nr_players; i < nr_new; ++i) {
+        create_player(&game->players[i]);
+        game->player_indices[i] = i;
+    }
+
+    game->nr_players = nr_new;
+
+    return true;
+}
+
 char *player_strncat(char *str, const struct gauntlet_player *p, const size_t len) {
     if (!str || !p) return NULL;
 
@@ -867,6 +1600,13 @@ bool game_start_client(struct gauntlet_game *game, const char *host_name) {
     client_send(game->client, game->message_buffer,
         game_create_net_message_name(game, game->menu.player_name));
     
+    //Receive messages from the host on a separate thread.
+    if (!game_start_client_thread(game)) {
+        free_clients(&game->client, 1);
+        menu_draw_message(&game->menu, "Unable to create client!");
+        return false;
+    }
+
     //Transition to lobby.
     game->menu.state = RETRO_GAUNTLET_STATE_LOBBY_CLIENT;
 
@@ -888,26 +1628,132 @@ bool game_stop_client(struct gauntlet_game *game) {
     game->client_recv_file = NULL;
 
     game_stop_gauntlet(game);
+    game_stop_client_thread(game);
     free_clients(&game->client, 1);
     game->menu.state = RETRO_GAUNTLET_STATE_SELECT_GAUNTLET;
 
     return true;
 }
 
+//Keep a message until the gauntlet is finished, such that later lobby updates do not have to wait behind it.
+static bool game_defer_message(struct gauntlet_game *game, const uint8_t *data, const size_t nr_data) {
+    if (game->nr_deferred_messages + nr_data > game->max_deferred_messages) {
+        const size_t max_deferred = max(2*game->max_deferred_messages, game->nr_deferred_messages + nr_data);
+        uint8_t *deferred = (uint8_t *)realloc(game->deferred_messages, max_deferred);
+
+        if (!deferred) {
+            fprintf(ERROR_FILE, "game_defer_message: Unable to allocate memory!\n");
+            return false;
+        }
+
+        game->deferred_messages = deferred;
+        game->max_deferred_messages = max_deferred;
+    }
+
+    memcpy(game->deferred_messages + game->nr_deferred_messages, data, nr_data);
+    game->nr_deferred_messages += nr_data;
+
+    return true;
+}
+
+//Apply deferred messages in the order they were received, keeping those that have to wait for the next gauntlet to finish.
+static bool game_apply_deferred_messages(struct gauntlet_game *game) {
+    size_t nr_kept = 0;
+    bool ok = true;
+
+    for (size_t i = 0; i < game->nr_deferred_messages; ) {
+        const uint8_t *data = game->deferred_messages + i;
+        uint16_t msg_type = 0;
+        uint32_t nr_data = 0;
+
+        memcpy(&msg_type, data + 2, sizeof(uint16_t));
+        memcpy(&nr_data, data + 4, sizeof(uint32_t));
+
+        if (!ok || (game->menu.state == RETRO_GAUNTLET_STATE_RUN_CORE && msg_type != RETRO_GAUNTLET_MSG_LOBBY)) {
+            memmove(game->deferred_messages + nr_kept, data, nr_data);
+            nr_kept += nr_data;
+        }
+        else {
+            ok = game_player_apply_message(game, &game->players[0], data, nr_data);
+        }
+
+        i += nr_data;
+    }
+
+    game->nr_deferred_messages = nr_kept;
+
+    return ok;
+}
+
 bool game_update_client(struct gauntlet_game *game) {
     if (!game) {
         fprintf(ERROR_FILE, "game_update_client: Invalid game!\n");
         return false;
     }
     
-    //Receive data.
-    if (!client_is_client_active(game->client) || !client_listen(game->client, 0)) {
+    struct gauntlet_player *p = &game->players[0];
+    struct gauntlet_message_queue *messages = &game->client_messages;
+
+    //Catch up on messages that arrived while running a core.
+    if (game->nr_deferred_messages > 0 && game->menu.state != RETRO_GAUNTLET_STATE_RUN_CORE && !game_apply_deferred_messages(game)) {
+        fprintf(ERROR_FILE, "game_update_client: Unable to apply message from host!\n");
         game_stop_client(game);
         menu_draw_message(&game->menu, "Connection to host lost!");
+        return false;
     }
 
-    //And process it.
-    if (!game_player_append_client_data(game, &game->players[0], game->client)) {
+    //Apply messages received by the client network thread, a bounded number per frame.
+    for (int i = 0; i < RETRO_GAUNTLET_CLIENT_MESSAGES_PER_FRAME; ++i) {
+        const uint8_t *data = p->data;
+        size_t nr_data = p->nr_data;
+        bool in_queue = false;
+
+        //Take the next message from the queue, unless a previous one has been copied out of it.
+        if (!player_has_message(p)) {
+            if (message_queue_available(messages) < 8) break;
+
+            //The network thread writes complete messages, so the remainder is available once the header is.
+            const size_t nr_contiguous = message_queue_peek(messages, &data);
+
+            if (nr_contiguous >= 8 && nr_contiguous >= *(const uint32_t *)(data + 4)) {
+                //Use the message directly from the queue.
+                nr_data = *(const uint32_t *)(data + 4);
+                in_queue = true;
+            }
+            else {
+                //The message wraps around the end of the queue, so copy it.
+                message_queue_read(messages, p->data, 8);
+                p->nr_data = p->nr_data_expected = *(uint32_t *)(p->data + 4);
+                message_queue_read(messages, p->data + 8, p->nr_data - 8);
+                data = p->data;
+                nr_data = p->nr_data;
+            }
+        }
+
+        //While running a core only lobby updates are applied, other messages wait until the gauntlet is finished.
+        const bool ok = (game->menu.state == RETRO_GAUNTLET_STATE_RUN_CORE && *(const uint16_t *)(data + 2) != RETRO_GAUNTLET_MSG_LOBBY ?
+                         game_defer_message(game, data, nr_data) : game_player_apply_message(game, p, data, nr_data));
+
+        //Data is no longer necessary.
+        if (in_queue) {
+            message_queue_skip(messages, nr_data);
+        }
+        else {
+            p->nr_data = 0;
+            p->nr_data_expected = 0;
+        }
+
+        if (!ok) {
+            fprintf(ERROR_FILE, "game_update_client: Unable to apply message from host!\n");
+            game_stop_client(game);
+            menu_draw_message(&game->menu, "Connection to host lost!");
+            return false;
+        }
+    }
+
+    //Report a lost connection once all messages have been applied, without interrupting a running gauntlet.
+    if (!game_is_client_active(game) && game->menu.state != RETRO_GAUNTLET_STATE_RUN_CORE &&
+        !player_has_message(p) && message_queue_available(messages) == 0) {
         game_stop_client(game);
         menu_draw_message(&game->menu, "Connection to host lost!");
     }
@@ -919,11 +1765,11 @@ void game_sort_player_indices_by_score(struct gauntlet_game *game) {
     //Use simple insertion sort.
     if (!game) return;
 
-    for (int i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 0; i < game->nr_players; ++i) {
         game->player_indices[i] = i;
     }
 
-    for (int i = 1; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
+    for (int i = 1; i < game->nr_players; ++i) {
         const int k = game->player_indices[i];
         int j;
         
@@ -945,15 +1791,19 @@ void game_update_lobby_text(struct gauntlet_game *game) {
     //If we are a client we will receive the lobby from the host.
     if (!host_is_host_active(game->host)) return;
 
-    //If we are the host, update the lobby state and send this out regularly.
-    strcpy(game->lobby_text, "Lobby:\n");
-    
-    game_sort_player_indices_by_score(game);
+    //If we are the host, update the lobby state when players or scores change and send this out regularly.
+    if (game->lobby_changed) {
+        game->lobby_changed = false;
+        game->menu_changed = true;
+        strcpy(game->lobby_text, "Lobby:\n");
+        
+        game_sort_player_indices_by_score(game);
 
-    for (int i = 0; i <= MAX_RETRO_GAUNTLET_CLIENTS; ++i) {
-        const int j = game->player_indices[i];
+        for (int i = 0; i < game->nr_players; ++i) {
+            const int j = game->player_indices[i];
 
-        if (j == 0 || host_is_client_active(game->host, j - 1)) player_strncat(game->lobby_text, &game->players[j], NR_RETRO_GAUNTLET_MENU_TEXT);
+            if (j == 0 || host_is_client_active(game->host, j - 1)) player_strncat(game->lobby_text, &game->players[j], NR_RETRO_GAUNTLET_MENU_TEXT);
+        }
     }
     
     //Send out lobby updates at ~4 [Hz].
@@ -970,6 +1820,12 @@ void game_update_lobby_text(struct gauntlet_game *game) {
 void game_update_menu_text(struct gauntlet_game *game) {
     if (!game) return;
 
+    //Only regenerate the text after input, network messages, or a change of state.
+    if (!game->menu_changed && game->menu.state == game->last_menu_state) return;
+
+    game->menu_changed = false;
+    game->last_menu_state = game->menu.state;
+
     switch (game->menu.state) {
         case RETRO_GAUNTLET_STATE_SELECT_GAUNTLET:
             do {
@@ -1097,6 +1953,7 @@ void game_update_menu_text(struct gauntlet_game *game) {
             }
 
             strcat(game->menu.text, ".\n");
+            sprintf(game->menu.text + strlen(game->menu.text), "\nAudio latency %.1f ms (average %.1f ms, budget %u ms).\n", game->sgci.audio_queued_latency, sdl_gl_if_get_mean_audio_latency(&game->sgci), game->sgci.audio_latency_target);
             break;
         case RETRO_GAUNTLET_STATE_MESSAGE:
         case RETRO_GAUNTLET_STATE_QUIT_CONFIRM:
@@ -1112,7 +1969,9 @@ void game_update_menu_text(struct gauntlet_game *game) {
             break;
         case RETRO_GAUNTLET_STATE_LOBBY_CLIENT:
             sprintf(game->menu.text, "Joined ");
+            SDL_LockMutex(game->client_mutex);
             client_sprintf(game->menu.text + strlen(game->menu.text), game->client);
+            SDL_UnlockMutex(game->client_mutex);
             strcat(game->menu.text, "\n<ESC>   : Leave lobby\n<F>     : Toggle fullscreen\n\n");
             if (strlen(game->menu.text) + strlen(game->lobby_text) + 1 < NR_RETRO_GAUNTLET_MENU_TEXT) strcat(game->menu.text, game->lobby_text);
             break;
@@ -1124,43 +1983,189 @@ void game_update_menu_text(struct gauntlet_game *game) {
     menu_draw(&game->menu);
 }
 
+//Run frames without video when we are behind, checking each of them for win/lose conditions.
+static void game_run_skipped_frames(struct gauntlet_game *game, struct frame_pacer *pacer, const size_t nr_skip) {
+    core_wait_for_snapshots(&game->sgci.core);
+    game->sgci.core_skip_video = true;
+    if (!game->emulation_threaded) video_bind_frame_buffer(&game->sgci.video);
+
+    for (size_t i = 0; i < nr_skip; ++i) {
+        gauntlet_check_status(&game->gauntlet, &game->sgci);
+        if (game->gauntlet.status != RETRO_GAUNTLET_RUNNING) break;
+
+        game->sgci.core.retro_run();
+        gauntlet_count_frame(&game->gauntlet, game->sgci.core.frames_per_second);
+        pacer->nr_frames++;
+    }
+
+    if (!game->emulation_threaded) video_unbind_frame_buffer(&game->sgci.video);
+    game->sgci.core_skip_video = false;
+}
+
+//Run a software-rendered core at its own pace, handing finished frames to the render thread.
+static int game_emulation_thread(void *data) {
+    struct gauntlet_game *game = (struct gauntlet_game *)data;
+
+    while (SDL_AtomicGet(&game->emulation_quit) == 0) {
+        frame_pacer_begin_frame(&game->emulation_pacer, NULL, game->sgci.core.frames_per_second);
+
+        SDL_LockMutex(game->emulation_mutex);
+        gauntlet_check_status(&game->gauntlet, &game->sgci);
+
+        const bool running = (game->gauntlet.status == RETRO_GAUNTLET_RUNNING);
+
+        if (running) {
+            core_wait_for_snapshots(&game->sgci.core);
+            sdl_gl_if_run_frame(&game->sgci);
+            gauntlet_count_frame(&game->gauntlet, game->sgci.core.frames_per_second);
+
+            //Compare memory snapshot if desired, overlapping with waiting for the next frame.
+            if (game->snapshot_data_condition == MASK_IF_DATA_CHANGED) core_start_snapshot_comparison(&game->sgci.core, game->snapshot_mask_condition, game->snapshot_data_condition, game->snapshot_mask_action, game->snapshot_mask_size, game->snapshot_const_value);
+        }
+
+        SDL_UnlockMutex(game->emulation_mutex);
+
+        if (!running) break;
+
+        const size_t nr_skip = frame_pacer_end_frame(&game->emulation_pacer);
+
+        if (nr_skip > 0) {
+            SDL_LockMutex(game->emulation_mutex);
+            game_run_skipped_frames(game, &game->emulation_pacer, nr_skip);
+            SDL_UnlockMutex(game->emulation_mutex);
+        }
+    }
+
+    core_wait_for_snapshots(&game->sgci.core);
+    SDL_AtomicSet(&game->emulation_active, 0);
+
+    return 0;
+}
+
+bool game_start_emulation_thread(struct gauntlet_game *game) {
+    if (!game || game->emulation_thread) {
+        fprintf(ERROR_FILE, "game_start_emulation_thread: Invalid game or thread already running!\n");
+        return false;
+    }
+
+    const struct gl_video *video = &game->sgci.video;
+
+    if (!create_video_triple_buffer(&game->emulation_frames, (size_t)video->max_width*(size_t)video->max_height*(size_t)video->bytes_per_pixel)) {
+        fprintf(ERROR_FILE, "game_start_emulation_thread: Unable to create frame buffers!\n");
+        return false;
+    }
+
+    frame_pacer_restart(&game->emulation_pacer, false);
+    SDL_AtomicSet(&game->emulation_quit, 0);
+    SDL_AtomicSet(&game->emulation_active, 1);
+    SDL_AtomicSet(&game->emulation_geometry_changed, 0);
+    game->emulation_threaded = true;
+
+    if (!(game->emulation_thread = SDL_CreateThread(game_emulation_thread, "emulation", game))) {
+        fprintf(ERROR_FILE, "game_start_emulation_thread: Unable to create thread: %s!\n", SDL_GetError());
+        game->emulation_threaded = false;
+        free_video_triple_buffer(&game->emulation_frames);
+        return false;
+    }
+
+    return true;
+}
+
+bool game_stop_emulation_thread(struct gauntlet_game *game) {
+    if (!game) {
+        fprintf(ERROR_FILE, "game_stop_emulation_thread: Invalid game!\n");
+        return false;
+    }
+
+    if (!game->emulation_thread) return true;
+
+    SDL_AtomicSet(&game->emulation_quit, 1);
+    SDL_WaitThread(game->emulation_thread, NULL);
+    game->emulation_thread = NULL;
+    game->emulation_threaded = false;
+    free_video_triple_buffer(&game->emulation_frames);
+    frame_pacer_restart(&game->pacer, false);
+
+    //Apply the last geometry change now that the core runs on this thread again.
+    if (SDL_AtomicSet(&game->emulation_geometry_changed, 0)) video_set_geometry(&game->sgci.video, &game->emulation_geometry);
+
+    return true;
+}
+
+//Sleep until there is user input, network activity, or the time out expires.
+static void game_wait_for_menu_event(struct gauntlet_game *game, const uint32_t time_out_ms) {
+    //Network threads wake us up with an event, @see game_wake_up().
+    if (game->client_thread && message_queue_available(&game->client_messages) > 0) return;
+
+    if (!game->host_thread || !host_is_host_active(game->host)) {
+        SDL_WaitEventTimeout(NULL, time_out_ms);
+        return;
+    }
+
+    //Let the host network thread wait for sockets, and make sure it is done before we use the host again.
+    SDL_AtomicSet(&game->host_waiting, 1);
+    SDL_SemPost(game->host_wait_start);
+    SDL_WaitEventTimeout(NULL, time_out_ms);
+    SDL_AtomicSet(&game->host_waiting, 0);
+    host_interrupt(game->host);
+    SDL_SemWait(game->host_wait_done);
+}
+
 void game_update(struct gauntlet_game *game) {
     if (!game) return;
     
     //Always perform host updates.
     if (host_is_host_active(game->host)) {
         game_update_host(game);
-        game_player_give_points(game);
+        if (game_player_give_points(game)) game->lobby_changed = true;
         game_update_lobby_text(game);
     }
 
+    //Clients receive messages on a separate thread, also while running a core.
+    if (game->client_thread) game_update_client(game);
+
     //Clear screen.
     GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-    if (game->start_ticks == 0) game->start_ticks = SDL_GetTicks();
-    game->nr_frames++;
+    frame_pacer_begin_frame(&game->pacer, game->window, game->sgci.core.frames_per_second);
+
+    bool present = true;
 
     //Are we running a core?
     if (game->menu.state == RETRO_GAUNTLET_STATE_RUN_CORE) {
+        //The core output covers the menu, so redraw it when returning to the menu.
+        game->menu.video.dirty = true;
+
+        if (game->emulation_thread) {
+            //The emulation thread checks win/lose conditions and stops when the gauntlet is finished.
+            if (SDL_AtomicGet(&game->emulation_active) == 0) game_stop_emulation_thread(game);
+        }
+        else if (game->menu.emulation_thread && !game->sgci.video.core_callback.get_current_framebuffer && game->gauntlet.status == RETRO_GAUNTLET_RUNNING) {
+            //Software-rendered cores do not need our OpenGL context and can run on their own thread.
+            if (!game_start_emulation_thread(game)) game->menu.emulation_thread = false;
+        }
+
         //Check whether we satisfy win/lose conditions.
-        gauntlet_check_status(&game->gauntlet, &game->sgci);
+        if (!game->emulation_thread) gauntlet_check_status(&game->gauntlet, &game->sgci);
         
         //Did we stop running?
-        if (game->gauntlet.status != RETRO_GAUNTLET_RUNNING) {
-            const uint32_t t = game->gauntlet.end_time - game->gauntlet.start_time;
+        if (!game->emulation_thread && game->gauntlet.status != RETRO_GAUNTLET_RUNNING) {
+            const uint32_t t = gauntlet_get_time(&game->gauntlet);
+            const uint32_t wt = gauntlet_get_wall_time(&game->gauntlet);
             const uint32_t pt = game->gauntlet.par_time;
             
             if (host_is_host_active(game->host)) game->menu.state = RETRO_GAUNTLET_STATE_LOBBY_HOST;
-            else if (client_is_client_active(game->client)) game->menu.state = RETRO_GAUNTLET_STATE_LOBBY_CLIENT;
+            else if (game_is_client_active(game)) game->menu.state = RETRO_GAUNTLET_STATE_LOBBY_CLIENT;
             else game->menu.state = RETRO_GAUNTLET_STATE_SELECT_GAUNTLET;
 
             const bool win = (game->gauntlet.status == RETRO_GAUNTLET_WON);
             
-            if (!host_is_host_active(game->host) && !client_is_client_active(game->client)) {
+            if (!host_is_host_active(game->host) && !game_is_client_active(game)) {
                 switch (game->gauntlet.status) {
                     case RETRO_GAUNTLET_WON:
-                        menu_draw_message(&game->menu, "You won!\n\nTime %02u:%02u:%02u.%03u (par %02u:%02u:%02u.%03u)\n",
+                        menu_draw_message(&game->menu, "You won!\n\nTime %02u:%02u:%02u.%03u (par %02u:%02u:%02u.%03u)\nWall-clock time %02u:%02u:%02u.%03u\n",
                             t/3600000u, (t/60000u) % 60u, (t/1000u) % 60u, t % 1000u,
-                            pt/3600000u, (pt/60000u) % 60u, (pt/1000u) % 60u, pt % 1000u);
+                            pt/3600000u, (pt/60000u) % 60u, (pt/1000u) % 60u, pt % 1000u,
+                            wt/3600000u, (wt/60000u) % 60u, (wt/1000u) % 60u, wt % 1000u);
                         break;
                     case RETRO_GAUNTLET_LOST:
                         menu_draw_message(&game->menu, "You lost!\n");
@@ -1171,13 +2176,23 @@ void game_update(struct gauntlet_game *game) {
                 }
             }
 
+            fprintf(INFO_FILE, "Finished after %llu frames, skipped %llu and dropped %llu frames to keep up.\n", (unsigned long long)game->gauntlet.nr_frames,
+                (unsigned long long)(game->pacer.nr_skipped_frames + game->emulation_pacer.nr_skipped_frames),
+                (unsigned long long)(game->pacer.nr_dropped_frames + game->emulation_pacer.nr_dropped_frames));
+            fprintf(INFO_FILE, "Audio queued %.1f ms on average (budget %u ms), overflowed %d and underran %d times.\n", sdl_gl_if_get_mean_audio_latency(&game->sgci), game->sgci.audio_latency_target,
+                SDL_AtomicGet(&game->sgci.audio_ring.nr_overflows), SDL_AtomicGet(&game->sgci.audio_ring.nr_underruns));
+            if (game->sgci.video.nr_uploads > 0) fprintf(INFO_FILE, "Uploading %llu frames took %.3f ms per frame.\n", (unsigned long long)game->sgci.video.nr_uploads, video_get_mean_upload_time(&game->sgci.video));
+            if (game->sgci.nr_runahead_runs > 0) fprintf(INFO_FILE, "Running %zu frames ahead cost %.3f ms per frame.\n", game->sgci.nr_runahead_frames, 1000.0*(double)game->sgci.runahead_ticks/((double)SDL_GetPerformanceFrequency()*(double)game->sgci.nr_runahead_runs));
+
             game->players[0].finish_state = game->gauntlet.status;
             game->players[0].finish_time = t;
+            game->players[0].finish_wall_time = wt;
+            game->lobby_changed = true;
 
-            if (client_is_client_active(game->client)) {
+            if (game_is_client_active(game)) {
                 //Update host the we completed the gauntlet.
-                client_send(game->client, game->message_buffer,
-                    game_create_net_message_finish(game, game->players[0].finish_state, game->players[0].finish_time));
+                game_client_send(game, game->message_buffer,
+                    game_create_net_message_finish(game, game->players[0].finish_state, game->players[0].finish_time, game->players[0].finish_wall_time));
             }
             
             if (host_is_host_active(game->host)) {
@@ -1189,53 +2204,76 @@ void game_update(struct gauntlet_game *game) {
             menu_start_mixer(&game->menu);
             soundboard_play(win ? &game->menu.win_board : &game->menu.lose_board, -1);
         }
+        else if (game->emulation_thread) {
+            //Apply geometry changes made by the core, which require our OpenGL context.
+            if (SDL_AtomicGet(&game->emulation_geometry_changed)) {
+                SDL_LockMutex(game->emulation_mutex);
+                if (SDL_AtomicSet(&game->emulation_geometry_changed, 0)) video_set_geometry(&game->sgci.video, &game->emulation_geometry);
+                SDL_UnlockMutex(game->emulation_mutex);
+            }
+
+            //Upload the most recent frame of the emulation thread, if any.
+            const struct video_frame *frame = video_triple_buffer_read(&game->emulation_frames);
+
+            if (frame) video_refresh_from_libretro(&game->sgci.video, frame->data, frame->width, frame->height, frame->pitch);
+
+            //Only redraw if the frame changed.
+            present = game->sgci.video.dirty;
+            if (present) video_render(&game->sgci.video);
+            game->sgci.video.dirty = false;
+        }
         else {
-            //Draw libretro core output.
+            //Draw libretro core output once the previous snapshot comparison no longer reads core memory.
+            core_wait_for_snapshots(&game->sgci.core);
             video_bind_frame_buffer(&game->sgci.video);
-            game->sgci.core.retro_run();
+            sdl_gl_if_run_frame(&game->sgci);
+            gauntlet_count_frame(&game->gauntlet, game->sgci.core.frames_per_second);
             video_unbind_frame_buffer(&game->sgci.video);
-            video_render(&game->sgci.video);
+
+            //Only redraw if the frame changed, e.g., not for duplicate frames.
+            present = game->sgci.video.dirty;
+            if (present) video_render(&game->sgci.video);
+            game->sgci.video.dirty = false;
             
-            //Compare memory snapshot if desired.
-            if (game->snapshot_data_condition == MASK_IF_DATA_CHANGED) core_take_and_compare_snapshots(&game->sgci.core, game->snapshot_mask_condition, game->snapshot_data_condition, game->snapshot_mask_action, game->snapshot_mask_size, game->snapshot_const_value);
+            //Compare memory snapshot if desired, overlapping with presenting the frame.
+            if (game->snapshot_data_condition == MASK_IF_DATA_CHANGED) core_start_snapshot_comparison(&game->sgci.core, game->snapshot_mask_condition, game->snapshot_data_condition, game->snapshot_mask_action, game->snapshot_mask_size, game->snapshot_const_value);
         }
     }
     else {
-        //Client network updates are performed only when we are not running a core.
-        if (client_is_client_active(game->client)) game_update_client(game);
-        
         //Update menu text.
         game_update_menu_text(game);
         
-        //Draw menu.
-        video_refresh_from_sdl_surface(&game->menu.video, game->menu.surface);
-        video_render(&game->menu.video);
+        //Draw menu only if its text changed or the window needs repainting.
+        present = game->menu.video.dirty;
+        if (present) video_render(&game->menu.video);
+        game->menu.video.dirty = false;
+
+        //The menu covers the core output, so redraw it when returning to the core.
+        game->sgci.video.dirty = true;
     }
     
-    //Update window.
-    SDL_GL_SwapWindow(game->window);
+    //Update window, keeping the previous frame on screen if nothing changed.
+    if (present) SDL_GL_SwapWindow(game->window);
+    else game->pacer.presented = false;
     
     //Check whether we are at the desired framerate.
     switch (game->menu.state) {
         case RETRO_GAUNTLET_STATE_RUN_CORE:
-            //Try to match the desired frames per second to avoid audio stuttering.
-            if (true) {
-                Uint32 desired_ticks = (Uint32)(1000.0*(double)game->nr_frames/game->sgci.core.frames_per_second);
-                Uint32 ticks = SDL_GetTicks() - game->start_ticks;
-        
-                if (desired_ticks > ticks) {
-                    SDL_Delay(desired_ticks - ticks);
-                }
-                else {
-                    //We are behind --> ask for another frame.
-                    game->sgci.core.retro_run();
-                    game->nr_frames++;
-                }
+            if (game->emulation_thread) {
+                //The emulation thread paces the core, sleep until it produces a new frame.
+                if (!present) video_triple_buffer_wait(&game->emulation_frames, RETRO_GAUNTLET_FRAME_WAIT_MS);
+            }
+            else {
+                //Try to match the desired frames per second to avoid audio stuttering.
+                const size_t nr_skip = frame_pacer_end_frame(&game->pacer);
+
+                //We are behind --> run frames without video.
+                if (nr_skip > 0) game_run_skipped_frames(game, &game->pacer, nr_skip);
             }
             break;
         default:
-            //100fps should be more than enough for the menu.
-            SDL_Delay(10);
+            //Sleep until something happens that could change the menu.
+            game_wait_for_menu_event(game, RETRO_GAUNTLET_MENU_WAIT_MS);
             break;
     }
 }
@@ -1261,6 +2299,7 @@ bool game_stop_gauntlet(struct gauntlet_game *game) {
         return false;
     }
     
+    game_stop_emulation_thread(game);
     SDL_ShowCursor(SDL_ENABLE);
     SDL_SetRelativeMouseMode(SDL_FALSE);
     gauntlet_stop(&game->gauntlet);
@@ -1268,7 +2307,7 @@ bool game_stop_gauntlet(struct gauntlet_game *game) {
     free_gauntlet(&game->gauntlet);
 
     //Set networking to be blocking.
-    if (client_is_client_active(game->client)) client_set_blocking(game->client, true);
+    game_client_set_blocking(game, true);
     if (host_is_host_active(game->host)) host_set_blocking(game->host, true);
 
     return true;
@@ -1292,7 +2331,7 @@ bool game_start_gauntlet(struct gauntlet_game *game, const char *gauntlet_ini_fi
     fprintf(INFO_FILE, "Opened gauntlet '%s' from '%s'.\n", game->gauntlet.title, gauntlet_ini_file);
 
     //Set networking to be non-blocking.
-    if (client_is_client_active(game->client)) client_set_blocking(game->client, false);
+    game_client_set_blocking(game, false);
     if (host_is_host_active(game->host)) host_set_blocking(game->host, false);
 
     SDL_SetRelativeMouseMode(SDL_TRUE);
@@ -1310,7 +2349,14 @@ void game_sdl_event(struct gauntlet_game *game, const SDL_Event event) {
         case SDL_QUIT:
             game->keep_running = false;
             break;
+        case SDL_USEREVENT:
+            //Wake-up from the client network thread, its messages are applied by game_update().
+            event_core = false;
+            break;
         case SDL_KEYDOWN:
+            //Keys select gauntlets and change settings shown in the menu.
+            game->menu_changed = true;
+
             switch (game->menu.state) {
                 case RETRO_GAUNTLET_STATE_MESSAGE:
                     //Remove message and return to previous menu screen.
@@ -1407,8 +2453,7 @@ void game_sdl_event(struct gauntlet_game *game, const SDL_Event event) {
                     switch (event.key.keysym.sym) {
                         case SDLK_PAUSE:
                             SDL_PauseAudioDevice(game->sgci.audio_device_id, 0);
-                            game->start_ticks = 0;
-                            game->nr_frames = 0;
+                            frame_pacer_restart(&game->pacer, false);
                             sdl_gl_if_reset_audio(&game->sgci);
                             game->menu.state = RETRO_GAUNTLET_STATE_RUN_CORE;
                             break;
@@ -1546,7 +2591,7 @@ void game_sdl_event(struct gauntlet_game *game, const SDL_Event event) {
                     switch (event.key.keysym.sym) {
                         case SDLK_PAUSE:
                             //Go to memory monitoring mode.
-                            if (!host_is_host_active(game->host) && !client_is_client_active(game->client)) {
+                            if (!host_is_host_active(game->host) && !game_is_client_active(game)) {
                                 SDL_PauseAudioDevice(game->sgci.audio_device_id, 1);
                                 game->menu.state = RETRO_GAUNTLET_STATE_SETUP_GAUNTLET;
                             }
@@ -1584,13 +2629,26 @@ void game_sdl_event(struct gauntlet_game *game, const SDL_Event event) {
                     break;
                 case SDL_WINDOWEVENT_SIZE_CHANGED:
                     video_set_window(&game->menu.video, event.window.data1, event.window.data2);
+                    game->sgci.video.dirty = true;
+                    game->menu.video.dirty = true;
+                    break;
+                case SDL_WINDOWEVENT_EXPOSED:
+                    game->sgci.video.dirty = true;
+                    game->menu.video.dirty = true;
                     break;
             }
             break;
     }
 
     //Pass events to libretro core if core is running.
-    if (event_core && game->menu.state == RETRO_GAUNTLET_STATE_RUN_CORE) sdl_gl_if_handle_event(&game->sgci, event);
+    if (event_core && game->menu.state == RETRO_GAUNTLET_STATE_RUN_CORE) {
+        if (game->emulation_thread) SDL_LockMutex(game->emulation_mutex);
+        sdl_gl_if_handle_event(&game->sgci, event);
+        if (game->emulation_thread) SDL_UnlockMutex(game->emulation_mutex);
+    }
+
+    //Return the core to this thread when pausing or leaving.
+    if (game->menu.state != RETRO_GAUNTLET_STATE_RUN_CORE) game_stop_emulation_thread(game);
 }
 
 
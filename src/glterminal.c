@@ -0,0 +1,178 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "dosfont.h"
+#include "glterminal.h"
+#include "glcheck.h"
+
+//Screen-filling triangle strip without vertex data.
+static const char *terminal_vertex_shader_code =
+"#version 330\n"
+"\n"
+"void main() {\n"
+"   gl_Position = vec4(2.0f*vec2(gl_VertexID & 1, gl_VertexID >> 1) - 1.0f, 0.0f, 1.0f);\n"
+"}\n";
+
+//Look up the glyph of the cell containing each pixel, with row 0 at the top of the screen as for SDL surfaces.
+static const char *terminal_fragment_shader_code =
+"#version 330\n"
+"\n"
+"uniform usampler2D cells;\n"
+"uniform sampler2D glyphs;\n"
+"uniform vec3 front_color;\n"
+"uniform vec3 back_color;\n"
+"\n"
+"out vec4 frag;\n"
+"\n"
+"void main() {\n"
+"   const ivec2 glyph_size = ivec2(9, 16);\n"
+"   ivec2 p = ivec2(gl_FragCoord.xy);\n"
+"   int c = int(texelFetch(cells, p/glyph_size, 0).r);\n"
+"   float g = texelFetch(glyphs, ivec2(c & 15, c >> 4)*glyph_size + p % glyph_size, 0).r;\n"
+"   frag = vec4(mix(back_color, front_color, g), 1.0f);\n"
+"}\n";
+
+bool create_gl_terminal(struct gl_terminal *terminal, const unsigned width, const unsigned height) {
+    if (!terminal || width == 0 || height == 0) {
+        fprintf(ERROR_FILE, "create_gl_terminal: Invalid terminal or size!\n");
+        return false;
+    }
+
+    memset(terminal, 0, sizeof(struct gl_terminal));
+    terminal->width = width;
+    terminal->height = height;
+
+    //Rasterize all glyphs once into a 16x16 atlas.
+    const unsigned atlas_width = 16*GL_TERMINAL_GLYPH_WIDTH;
+    const unsigned atlas_height = 16*GL_TERMINAL_GLYPH_HEIGHT;
+    uint8_t *atlas = (uint8_t *)calloc(atlas_width*atlas_height, 1);
+
+    if (!atlas) {
+        fprintf(ERROR_FILE, "create_gl_terminal: Unable to allocate glyph atlas!\n");
+        return false;
+    }
+
+    for (unsigned c = 0; c < 256; ++c) {
+        uint8_t *p = atlas + (c >> 4)*GL_TERMINAL_GLYPH_HEIGHT*atlas_width + (c & 15)*GL_TERMINAL_GLYPH_WIDTH;
+        const uint8_t *f = &dos_font[16*c];
+
+        for (int y = 0; y < GL_TERMINAL_GLYPH_HEIGHT; ++y, p += atlas_width) {
+            const uint8_t l = *f++;
+
+            for (int x = 0; x < 8; ++x) p[x] = ((l << x) & 128 ? 255 : 0);
+
+            //http://support.microsoft.com/kb/59953: The width of CGA, EGA, MCGA, and VGA text characters is 8 pixels. In the case of VGA however, 9 pixels are actually used for displaying the characters. The 9th pixel is appended to the right end of each pixel row. If the character being displayed has an ASCII code ranging from 192 to 223 and the 8th pixel in a given pixel row is on, the 9th pixel in that row will be on also. If the 8th pixel in the row is off or the ASCII code for the character is not in the range 192 to 223, the 9th pixel will not be turned on.
+            p[8] = ((l & 1) != 0 && c >= 192 && c < 224 ? 255 : 0);
+        }
+    }
+
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CHECK(glGenTextures(1, &terminal->glyph_texture));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, terminal->glyph_texture));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas_width, atlas_height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas));
+
+    GL_CHECK(glGenTextures(1, &terminal->cell_texture));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, terminal->cell_texture));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+    free(atlas);
+
+    //Create shader program.
+    terminal->program = glCreateProgram();
+    terminal->vertex_shader = gl_compile_shader(terminal_vertex_shader_code, GL_VERTEX_SHADER);
+    terminal->fragment_shader = gl_compile_shader(terminal_fragment_shader_code, GL_FRAGMENT_SHADER);
+
+    if (!terminal->program || !terminal->vertex_shader || !terminal->fragment_shader) {
+        fprintf(ERROR_FILE, "create_gl_terminal: Unable to create OpenGL program or shaders!\n");
+        free_gl_terminal(terminal);
+        return false;
+    }
+
+    GL_CHECK(glAttachShader(terminal->program, terminal->vertex_shader));
+    GL_CHECK(glAttachShader(terminal->program, terminal->fragment_shader));
+    GL_CHECK(glLinkProgram(terminal->program));
+
+    GLint is_program_linked = GL_FALSE;
+
+    GL_CHECK(glGetProgramiv(terminal->program, GL_LINK_STATUS, &is_program_linked));
+
+    if (is_program_linked != GL_TRUE) {
+        fprintf(ERROR_FILE, "create_gl_terminal: Unable to link OpenGL program!\n");
+        free_gl_terminal(terminal);
+        return false;
+    }
+
+    GL_CHECK(glUseProgram(terminal->program));
+    GL_CHECK(glUniform1i(glGetUniformLocation(terminal->program, "cells"), 0));
+    GL_CHECK(glUniform1i(glGetUniformLocation(terminal->program, "glyphs"), 1));
+    GL_CHECK(glUseProgram(0));
+
+    //Core profiles require a vertex array, even without vertex data.
+    GL_CHECK(glGenVertexArrays(1, &terminal->vertex_array));
+
+    return true;
+}
+
+bool free_gl_terminal(struct gl_terminal *terminal) {
+    if (!terminal) {
+        fprintf(ERROR_FILE, "free_gl_terminal: Invalid terminal!\n");
+        return false;
+    }
+
+    if (terminal->glyph_texture) glDeleteTextures(1, &terminal->glyph_texture);
+    if (terminal->cell_texture) glDeleteTextures(1, &terminal->cell_texture);
+    if (terminal->program) glDeleteProgram(terminal->program);
+    if (terminal->vertex_shader) glDeleteShader(terminal->vertex_shader);
+    if (terminal->fragment_shader) glDeleteShader(terminal->fragment_shader);
+    if (terminal->vertex_array) glDeleteVertexArrays(1, &terminal->vertex_array);
+
+    memset(terminal, 0, sizeof(struct gl_terminal));
+
+    return true;
+}
+
+//Draw the cells into the texture of a video, such that it can be rendered with the video's own shaders.
+void gl_terminal_draw(struct gl_terminal *terminal, const uint8_t *cells, const SDL_Color front_color, const SDL_Color back_color, struct gl_video *video) {
+    if (!terminal || !terminal->program || !cells || !video) return;
+
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CHECK(glActiveTexture(GL_TEXTURE0));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, terminal->cell_texture));
+    GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, terminal->width, terminal->height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells));
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    GL_CHECK(glActiveTexture(GL_TEXTURE1));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, terminal->glyph_texture));
+
+    video_bind_frame_buffer(video);
+    GL_CHECK(glUseProgram(terminal->program));
+    GL_CHECK(glUniform3f(glGetUniformLocation(terminal->program, "front_color"), front_color.r/255.0f, front_color.g/255.0f, front_color.b/255.0f));
+    GL_CHECK(glUniform3f(glGetUniformLocation(terminal->program, "back_color"), back_color.r/255.0f, back_color.g/255.0f, back_color.b/255.0f));
+    GL_CHECK(glBindVertexArray(terminal->vertex_array));
+    GL_CHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    GL_CHECK(glBindVertexArray(0));
+    GL_CHECK(glUseProgram(0));
+    video_unbind_frame_buffer(video);
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+    GL_CHECK(glActiveTexture(GL_TEXTURE0));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+
+    video->dirty = true;
+}
+
@@ -95,7 +95,11 @@ bool free_video_shaders(struct gl_video *video) {
 }
 
 void video_update_screen_quad(struct gl_video *video) {
-    if (!video || !video->vertex_buffer || !video->program) return;
+    if (!video) return;
+
+    video->dirty = true;
+
+    if (!video->vertex_buffer || !video->program) return;
 
     //Update quad to right dimensions.
     const GLfloat w = (GLfloat)video->base_width/(GLfloat)video->max_width;
@@ -324,6 +328,102 @@ void video_refresh_from_sdl_surface(struct gl_video *video, SDL_Surface *surf) {
     SDL_UnlockSurface(surf);
 }
 
+//Compare a frame with the previous one row by row, returning the spans of rows that changed and updating the previous frame.
+static size_t video_find_dirty_spans(struct gl_video *video, const uint8_t *data, const unsigned width, const unsigned height, const size_t pitch, unsigned spans[][2]) {
+    const size_t nr_row_bytes = (size_t)width*video->bytes_per_pixel;
+
+    if (!video->previous_frame || nr_row_bytes*height > video->nr_previous_frame_bytes) {
+        spans[0][0] = 0;
+        spans[0][1] = height;
+        return 1;
+    }
+
+    //Everything changed if the frame dimensions differ.
+    const bool resized = (width != video->previous_width || height != video->previous_height);
+    size_t nr_spans = 0;
+
+    video->previous_width = width;
+    video->previous_height = height;
+
+    for (unsigned y = 0; y < height; ++y) {
+        uint8_t *previous = video->previous_frame + y*nr_row_bytes;
+        const uint8_t *row = data + y*pitch;
+
+        if (!resized && memcmp(previous, row, nr_row_bytes) == 0) continue;
+
+        memcpy(previous, row, nr_row_bytes);
+
+        //Merge rows into the last span if they are close enough, avoiding many small uploads.
+        if (nr_spans > 0 && (y - spans[nr_spans - 1][1] <= VIDEO_DIRTY_ROW_GAP || nr_spans == MAX_VIDEO_DIRTY_SPANS)) {
+            spans[nr_spans - 1][1] = y + 1;
+        }
+        else {
+            spans[nr_spans][0] = y;
+            spans[nr_spans][1] = y + 1;
+            ++nr_spans;
+        }
+    }
+
+    return nr_spans;
+}
+
+//Copy changed rows into the next pixel buffer and let the driver upload them to the texture asynchronously.
+static bool video_upload_with_pixel_buffer(struct gl_video *video, const uint8_t *data, const unsigned width, const unsigned height, const size_t pitch, unsigned spans[][2], const size_t nr_spans) {
+    const size_t nr_row_bytes = (size_t)width*video->bytes_per_pixel;
+
+    if (!video->pixel_buffers[0] || nr_row_bytes*height > video->nr_pixel_buffer_bytes) return false;
+
+    const unsigned i = video->i_pixel_buffer;
+    uint8_t *dest = video->pixel_buffer_maps[i];
+
+    video->i_pixel_buffer = (i + 1) % NR_VIDEO_PIXEL_BUFFERS;
+    GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video->pixel_buffers[i]));
+
+    if (dest) {
+        //Wait until the driver no longer reads from this buffer, which should be long done after cycling through the others.
+        if (video->pixel_buffer_fences[i]) {
+            glClientWaitSync(video->pixel_buffer_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(video->pixel_buffer_fences[i]);
+            video->pixel_buffer_fences[i] = 0;
+        }
+    }
+    else {
+        //Orphan the previous storage such that mapping does not wait for pending uploads.
+        GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, video->nr_pixel_buffer_bytes, NULL, GL_STREAM_DRAW));
+        dest = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, nr_row_bytes*height, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if (!dest) {
+        GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        return false;
+    }
+
+    for (size_t j = 0; j < nr_spans; ++j) {
+        if (pitch == nr_row_bytes) {
+            memcpy(dest + spans[j][0]*nr_row_bytes, data + spans[j][0]*pitch, (spans[j][1] - spans[j][0])*nr_row_bytes);
+        }
+        else {
+            for (unsigned y = spans[j][0]; y < spans[j][1]; ++y) memcpy(dest + y*nr_row_bytes, data + y*pitch, nr_row_bytes);
+        }
+    }
+
+    if (!video->pixel_buffer_maps[i]) GL_CHECK(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, video->texture));
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, get_alignment(nr_row_bytes)));
+
+    for (size_t j = 0; j < nr_spans; ++j) {
+        GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, spans[j][0], width, spans[j][1] - spans[j][0], video->pixel_format, video->pixel_type, (const void *)(spans[j][0]*nr_row_bytes)));
+    }
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+    GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    if (video->pixel_buffer_maps[i]) video->pixel_buffer_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    return true;
+}
+
 void video_refresh_from_libretro(struct gl_video *video, const void *data, unsigned width, unsigned height, size_t pitch) {
     if (!data || !video) return;
 
@@ -333,33 +433,42 @@ void video_refresh_from_libretro(struct gl_video *video, const void *data, unsig
         video_update_screen_quad(video);
     }
 
-    if (data && data != RETRO_HW_FRAME_BUFFER_VALID) {
-        /*
-        printf("BUFFER %u, %u to texture %u\n", width, height, video->texture);
-        
-        uint32_t test[] = {0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff,
-                           0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff, 0xffffffff, 0xff0000ff};
-
-        GL_CHECK(glBindTexture(GL_TEXTURE_2D, video->texture));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, get_alignment(8*4)));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 8));
-        GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 7, video->pixel_format, video->pixel_type, test));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
-        GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
-        */
-
-        GL_CHECK(glBindTexture(GL_TEXTURE_2D, video->texture));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, get_alignment(pitch)));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch/video->bytes_per_pixel));
-        GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, video->pixel_format, video->pixel_type, data));
-        GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
-        GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+    if (data == RETRO_HW_FRAME_BUFFER_VALID) {
+        //The core rendered into our frame buffer directly.
+        video->dirty = true;
     }
+    else {
+        const uint64_t start = SDL_GetPerformanceCounter();
+        unsigned spans[MAX_VIDEO_DIRTY_SPANS][2];
+        const size_t nr_spans = video_find_dirty_spans(video, (const uint8_t *)data, width, height, pitch, spans);
+
+        //Duplicate frames need neither an upload nor a redraw.
+        if (nr_spans == 0) return;
+
+        //Fall back to a synchronous upload directly from core memory.
+        if (!video_upload_with_pixel_buffer(video, (const uint8_t *)data, width, height, pitch, spans, nr_spans)) {
+            GL_CHECK(glBindTexture(GL_TEXTURE_2D, video->texture));
+            GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, get_alignment(pitch)));
+            GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch/video->bytes_per_pixel));
+
+            for (size_t j = 0; j < nr_spans; ++j) {
+                GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, spans[j][0], width, spans[j][1] - spans[j][0], video->pixel_format, video->pixel_type, (const uint8_t *)data + spans[j][0]*pitch));
+            }
+
+            GL_CHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+            GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+        }
+
+        video->dirty = true;
+        video->upload_ticks += SDL_GetPerformanceCounter() - start;
+        video->nr_uploads++;
+    }
+}
+
+double video_get_mean_upload_time(const struct gl_video *video) {
+    if (!video || video->nr_uploads == 0) return 0.0;
+
+    return 1000.0*(double)video->upload_ticks/((double)SDL_GetPerformanceFrequency()*(double)video->nr_uploads);
 }
 
 bool video_set_pixel_format(struct gl_video *video, const enum retro_pixel_format format) {
@@ -395,6 +504,9 @@ bool video_set_pixel_format(struct gl_video *video, const enum retro_pixel_forma
             return false;
     }
 
+    video->previous_width = 0;
+    video->dirty = true;
+
     fprintf(INFO_FILE, "Set screen pixel format to %u, %u, %u bytes per pixel from %u.\n", video->pixel_type, video->pixel_format, video->bytes_per_pixel, format);
 
     return true;
@@ -405,6 +517,9 @@ void video_bind_frame_buffer(struct gl_video *video) {
         fprintf(ERROR_FILE, "video_bind_frame_buffer: Invalid video!\n");
         return;
     }
+
+    //No framebuffer is available when running headless.
+    if (!video->frame_buffer) return;
     
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, video->frame_buffer));
     GL_CHECK(glViewport(0, 0, video->base_width, video->base_height));
@@ -416,11 +531,32 @@ void video_unbind_frame_buffer(struct gl_video *video) {
         fprintf(ERROR_FILE, "video_bind_frame_buffer: Invalid video!\n");
         return;
     }
+
+    if (!video->frame_buffer) return;
     
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
+static void free_video_pixel_buffers(struct gl_video *video) {
+    for (int i = 0; i < NR_VIDEO_PIXEL_BUFFERS; ++i) {
+        if (video->pixel_buffer_fences[i]) glDeleteSync(video->pixel_buffer_fences[i]);
+        video->pixel_buffer_fences[i] = 0;
+
+        if (video->pixel_buffer_maps[i]) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video->pixel_buffers[i]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        video->pixel_buffer_maps[i] = NULL;
+    }
+
+    if (video->pixel_buffers[0]) glDeleteBuffers(NR_VIDEO_PIXEL_BUFFERS, video->pixel_buffers);
+    memset(video->pixel_buffers, 0, sizeof(video->pixel_buffers));
+    video->nr_pixel_buffer_bytes = 0;
+}
+
 bool free_video_buffers(struct gl_video *video) {
     //Will only free allocated data, size settings will be retained.
     if (!video) {
@@ -437,9 +573,48 @@ bool free_video_buffers(struct gl_video *video) {
     if (video->texture) glDeleteTextures(1, &video->texture);
     video->texture = 0;
 
+    free_video_pixel_buffers(video);
+
+    if (video->previous_frame) free(video->previous_frame);
+    video->previous_frame = NULL;
+    video->nr_previous_frame_bytes = 0;
+
     return true;
 }
 
+//Create pixel buffers for software-rendered frames, persistently mapped if supported.
+static void create_video_pixel_buffers(struct gl_video *video) {
+    video->nr_pixel_buffer_bytes = (size_t)video->max_width*(size_t)video->max_height*(size_t)video->bytes_per_pixel;
+    video->i_pixel_buffer = 0;
+
+    GL_CHECK(glGenBuffers(NR_VIDEO_PIXEL_BUFFERS, video->pixel_buffers));
+
+    for (int i = 0; i < NR_VIDEO_PIXEL_BUFFERS; ++i) {
+        GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video->pixel_buffers[i]));
+
+        if (GLEW_ARB_buffer_storage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            GL_CHECK(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, video->nr_pixel_buffer_bytes, NULL, flags));
+            video->pixel_buffer_maps[i] = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, video->nr_pixel_buffer_bytes, flags);
+        }
+        else {
+            GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, video->nr_pixel_buffer_bytes, NULL, GL_STREAM_DRAW));
+        }
+    }
+
+    GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    //Fall back to uploading directly from core memory.
+    if (GLEW_ARB_buffer_storage && !video->pixel_buffer_maps[NR_VIDEO_PIXEL_BUFFERS - 1]) {
+        fprintf(ERROR_FILE, "create_video_pixel_buffers: Unable to map pixel buffers, uploading frames synchronously!\n");
+        free_video_pixel_buffers(video);
+        return;
+    }
+
+    fprintf(INFO_FILE, "Streaming frames through %d pixel buffers of %zu bytes (%s).\n", NR_VIDEO_PIXEL_BUFFERS, video->nr_pixel_buffer_bytes, GLEW_ARB_buffer_storage ? "persistently mapped" : "mapped per frame");
+}
+
 bool create_video_buffers(struct gl_video *video) {
     if (!video || video->base_width == 0 || video->base_height == 0 || video->base_width > video->max_width || video->base_height > video->max_height) {
         fprintf(ERROR_FILE, "create_video_buffers: Invalid video object or invalid screen dimensions!\n");
@@ -478,6 +653,20 @@ bool create_video_buffers(struct gl_video *video) {
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
 
+    //Hardware-rendered cores draw into the frame buffer directly and the menu draws through the terminal renderer.
+    if (video->stream_frames && !video->core_callback.get_current_framebuffer) {
+        create_video_pixel_buffers(video);
+
+        //Without a copy of the previous frame we upload all rows.
+        video->nr_previous_frame_bytes = (size_t)video->max_width*(size_t)video->max_height*(size_t)video->bytes_per_pixel;
+        video->previous_frame = (uint8_t *)malloc(video->nr_previous_frame_bytes);
+        if (!video->previous_frame) video->nr_previous_frame_bytes = 0;
+    }
+
+    video->previous_width = 0;
+    video->previous_height = 0;
+    video->dirty = true;
+
     video_bind_frame_buffer(video);
     if (video->core_callback.context_reset) video->core_callback.context_reset();
     video_unbind_frame_buffer(video);
@@ -0,0 +1,61 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Headless benchmark runner: runs a single gauntlet for a fixed number of frames without window, OpenGL context, or audio device.
+#include <string.h>
+#include <SDL.h>
+
+#include "retrogauntlet.h"
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "--verify-snapshots") == 0) {
+        //Cross-check the SIMD memory inspection kernels against the scalar implementation.
+        if (SDL_Init(SDL_INIT_TIMER) < 0) {
+            fprintf(ERROR_FILE, "Unable to initialize SDL: %s!\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+
+        const bool result = retrogauntlet_verify_snapshot_kernels();
+
+        SDL_Quit();
+
+        return (result ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (argc != 3 && argc != 4) {
+        fprintf(ERROR_FILE, "Usage: %s data/ gauntlet.ini [nr_frames]\n       %s --verify-snapshots\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(INFO_FILE, "Welcome to the Retro Gauntlet version %s benchmark.\n", RETRO_GAUNTLET_VERSION);
+    
+    const char *data_directory = argv[1];
+    const char *ini_file = argv[2];
+    long nr_frames = 3600;
+
+    if (argc > 3) nr_frames = atol(argv[3]);
+
+    if (nr_frames <= 0) {
+        fprintf(ERROR_FILE, "Invalid number of frames '%s'!\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    //Initialize SDL without video and audio.
+    if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) < 0) {
+        fprintf(ERROR_FILE, "Unable to initialize SDL: %s!\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    const bool result = retrogauntlet_benchmark(data_directory, ini_file, (size_t)nr_frames);
+
+    SDL_Quit();
+
+    return (result ? EXIT_SUCCESS : EXIT_FAILURE);
+}
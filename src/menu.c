@@ -9,13 +9,14 @@ Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT AN
 You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
 */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "stringextra.h"
 #include "files.h"
 #include "ini.h"
-#include "dosfont.h"
 #include "menu.h"
+#include "framepacer.h"
 
 bool create_soundboard(struct soundboard *board) {
     if (!board) {
@@ -139,6 +140,25 @@ static int menu_ini_handler(void *user, const char *section, const char *name, c
     if (strcmp(section, "menu") == 0 && strcmp(name, "front_color") == 0) menu->front_color = get_sdl_color_from_html_hex(value);
     if (strcmp(section, "menu") == 0 && strcmp(name, "back_color") == 0) menu->back_color = get_sdl_color_from_html_hex(value);
     
+    if (strcmp(section, "video") == 0 && strcmp(name, "pacing") == 0) {
+             if (strcmp(value, "vsync") == 0) menu->frame_pacing = FRAME_PACER_VSYNC;
+        else if (strcmp(value, "free") == 0) menu->frame_pacing = FRAME_PACER_FREE_RUN;
+        else if (strcmp(value, "adaptive") == 0) menu->frame_pacing = FRAME_PACER_ADAPTIVE;
+    }
+    if (strcmp(section, "video") == 0 && strcmp(name, "max_frame_skip") == 0) {
+        const int nr_frames = atoi(value);
+
+        menu->max_frame_skip = (unsigned)max(0, min(nr_frames, MAX_RETRO_GAUNTLET_FRAME_SKIP));
+        if ((unsigned)nr_frames != menu->max_frame_skip) fprintf(WARN_FILE, "menu_ini_handler: Clamped maximum frame skip of %d to %u frames!\n", nr_frames, menu->max_frame_skip);
+    }
+    if (strcmp(section, "video") == 0 && strcmp(name, "emulation_thread") == 0) menu->emulation_thread = (strcmp(value, "yes") == 0);
+    if (strcmp(section, "audio") == 0 && strcmp(name, "latency") == 0) {
+        const int latency = atoi(value);
+
+        menu->audio_latency = (unsigned)max(MIN_RETRO_GAUNTLET_AUDIO_LATENCY, min(latency, MAX_RETRO_GAUNTLET_AUDIO_LATENCY));
+        if ((unsigned)latency != menu->audio_latency) fprintf(WARN_FILE, "menu_ini_handler: Clamped audio latency of %d to %u ms!\n", latency, menu->audio_latency);
+    }
+    
     if (strcmp(section, "network") == 0 && strcmp(name, "password") == 0) strncpy_trim(menu->password, value, NR_RETRO_GAUNTLET_PASSWORD);
     if (strcmp(section, "network") == 0 && strcmp(name, "port") == 0) menu->network_port = atoi(value);
     if (strcmp(section, "network") == 0 && strcmp(name, "name") == 0) strncpy(menu->player_name, value, NR_RETRO_GAUNTLET_NAME);
@@ -174,6 +194,10 @@ bool create_menu(struct retrogauntlet_menu *menu, const char *ini_file, const ch
     strcpy(menu->password, "Retr0G4untlet!");
     strcpy(menu->player_name, "Player");
     menu->network_port = 1337;
+    menu->frame_pacing = FRAME_PACER_VSYNC;
+    menu->max_frame_skip = 4;
+    menu->emulation_thread = true;
+    menu->audio_latency = 32;
 
     if (!create_soundboard(&menu->win_board) ||
         !create_soundboard(&menu->lose_board) ||
@@ -209,8 +233,8 @@ bool create_menu(struct retrogauntlet_menu *menu, const char *ini_file, const ch
     video_set_pixel_format(&menu->video, RETRO_PIXEL_FORMAT_GAUNTLET);
     create_video_buffers(&menu->video);
 
-    if (!(menu->surface = video_get_sdl_surface(&menu->video))) {
-        fprintf(ERROR_FILE, "create_menu: Unable to create SDL surface: %s!\n", SDL_GetError());
+    if (!create_gl_terminal(&menu->terminal_renderer, 80, 25)) {
+        fprintf(ERROR_FILE, "create_menu: Unable to create terminal renderer!\n");
         free_menu(menu);
         return false;
     }
@@ -232,7 +256,7 @@ bool free_menu(struct retrogauntlet_menu *menu) {
     if (menu->fragment_shader_code) free(menu->fragment_shader_code);
 
     if (menu->music) Mix_FreeMusic(menu->music);
-    if (menu->surface) SDL_FreeSurface(menu->surface);
+    free_gl_terminal(&menu->terminal_renderer);
     free_video(&menu->video);
     free_soundboard(&menu->win_board);
     free_soundboard(&menu->lose_board);
@@ -247,17 +271,13 @@ bool free_menu(struct retrogauntlet_menu *menu) {
 #define TERM_H 25
 
 void menu_draw(struct retrogauntlet_menu *menu) {
-    if (!menu || !menu->surface) return;
+    if (!menu || !menu->terminal_renderer.program) return;
 
     //No change --> no need to update.
     if (strcmp(menu->text, menu->last_text) == 0) return;
 
     strcpy(menu->last_text, menu->text);
 
-    SDL_Surface * const surf = menu->surface;
-    const uint32_t fg = SDL_MapRGBA(surf->format, menu->front_color.r, menu->front_color.g, menu->front_color.b, 0xff);
-    const uint32_t bg = SDL_MapRGBA(surf->format, menu->back_color.r, menu->back_color.g, menu->back_color.b, 0xff);
-
     //Clear terminal.
     memset(menu->terminal, 0, TERM_W*TERM_H);
     
@@ -298,45 +318,8 @@ void menu_draw(struct retrogauntlet_menu *menu) {
         if (c == 0) break;
     }
     
-    //Clear screen.
-    SDL_FillRect(surf, NULL, bg);
-
-    if (SDL_MUSTLOCK(surf) == SDL_TRUE) SDL_LockSurface(surf);
-
-    //Fill 720x400 screen with 80x25 text consisting of 9x16 character glyphs.
-
-    //Pitch in dwords.
-    const int pitch = surf->pitch/sizeof(uint32_t);
-    uint32_t *p = (uint32_t *)surf->pixels;
-    t = menu->terminal;
-
-    for (int y = 0; y < TERM_H; ++y) {
-        uint32_t *p2 = p;
-        uint8_t c;
-
-        for (int x = 0; x < TERM_W; ++x, p2 += 9) {
-            //Get character.
-            c = *t++;
-
-            //Draw single character.
-            uint32_t *p3 = p2;
-            const uint8_t *f = &dos_font[16*(int)c];
-
-            for (int y2 = 0; y2 < 16; ++y2, p3 += pitch - 9) {
-                uint8_t l = *f++;
-
-                for (int x2 = 0; x2 < 7; ++x2, l <<= 1) *p3++ = ((l & 128) != 0 ? fg : bg);
-                
-                //http://support.microsoft.com/kb/59953: The width of CGA, EGA, MCGA, and VGA text characters is 8 pixels. In the case of VGA however, 9 pixels are actually used for displaying the characters. The 9th pixel is appended to the right end of each pixel row. If the character being displayed has an ASCII code ranging from 192 to 223 and the 8th pixel in a given pixel row is on, the 9th pixel in that row will be on also. If the 8th pixel in the row is off or the ASCII code for the character is not in the range 192 to 223, the 9th pixel will not be turned on.
-                *p3++ = ((l & 128) != 0 ? fg : bg);
-                *p3++ = ((l & 128) != 0 && c >= 192 && c < 224 ? fg : bg);
-            }
-        }
-
-        p += 16*pitch;
-    }
-    
-    if (SDL_MUSTLOCK(surf) == SDL_TRUE) SDL_UnlockSurface(surf);
+    //Render glyphs on the GPU into the menu texture.
+    gl_terminal_draw(&menu->terminal_renderer, menu->terminal, menu->front_color, menu->back_color, &menu->video);
 }
 
 void menu_escape(struct retrogauntlet_menu *menu, const char *format, ...) {
@@ -13,6 +13,8 @@ You should have received a copy of the GNU General Public License along with Ret
 #include <string.h>
 
 #ifdef _WIN32
+//Allow select() to watch more than the default 64 sockets.
+#define FD_SETSIZE 1024
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <iphlpapi.h>
@@ -27,6 +29,12 @@ You should have received a copy of the GNU General Public License along with Ret
 #include <fcntl.h>
 #endif
 
+//Use epoll to only visit ready sockets on Linux, falling back to select() elsewhere.
+#ifdef __linux__
+#define NET_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #include <unistd.h>
 #include <errno.h>
 
@@ -36,16 +44,36 @@ You should have received a copy of the GNU General Public License along with Ret
 //Implementation based on examples from https://www.lugod.org/presentations/ipv6programming/ and https://learn.microsoft.com/en-us/windows/win32/winsock/appendix-b-ip-version-agnostic-source-code-2/.
 
 //Abstract away exact definitions of client/host structures to enable compatibility with SteamWorks.
+//Size of the receive ring buffer of a client, a power of two.
 #define NR_NET_BUFFER 65536
 
+//Number of pending connections the host socket queues.
+#define NR_NET_LISTEN_BACKLOG 128
+
+//Initial number of client slots of a host, doubled whenever all slots are in use.
+#define NR_NET_MIN_CLIENT_SLOTS 16
+
+//Number of ready sockets handled per host_listen() call.
+#define NR_NET_EPOLL_EVENTS 64
+
+//Epoll event data identifying the wake up socket of a host.
+#define NET_WAKE_EVENT UINT64_MAX
+
+//Number of bytes queued for a client beyond which the host drops it as too slow.
+#define NR_NET_SEND_QUEUE_LIMIT (4 << 20)
+
 struct client {
     char addr_text[INET6_ADDRSTRLEN];
     int port;
     int sock;
     uint8_t buffer[NR_NET_BUFFER + 1];
+    size_t buffer_begin; /**< Position of the first received byte in the ring buffer. */
     size_t nr_buffer;
     int newly_joined;
     bool blocking;
+    uint8_t *send_queue; /**< Outbound data the socket did not accept yet, between send_queue_begin and send_queue_end. */
+    size_t send_queue_size, send_queue_begin, send_queue_end;
+    bool send_watched; /**< Whether we wait for the socket to become writable. */
 };
 
 struct host {
@@ -53,12 +81,22 @@ struct host {
     int port;
     int sock;
     int max_clients;
-    struct client *clients;
+    struct client **clients;
+    int nr_client_slots;
     int nr_clients;
     int accepts_clients;
     bool blocking;
+    int wake_sock; /**< Loopback socket connected to itself, used to interrupt host_wait(). */
+#ifdef NET_USE_EPOLL
+    int epoll_fd;
+#endif
 };
 
+static bool host_watch_socket(struct host *, const int, const int);
+static void host_unwatch_socket(struct host *, const int);
+static void host_watch_send(struct host *, const int);
+static bool host_watch_wake_socket(struct host *);
+
 //Turn an address into a string that can be read by users.
 const char *get_addr_string(const struct sockaddr *addr, char *text, size_t max_text) {
     if (!addr || !text || max_text == 0) return NULL;
@@ -128,6 +166,129 @@ void close_socket_gen(const int sock) {
 #endif
 }
 
+//Whether a failed send() or recv() only indicates that the socket is not ready.
+bool socket_would_block() {
+#ifdef _WIN32
+    return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+#endif
+}
+
+//Get flags for sending to non-blocking sockets, avoiding SIGPIPE when the peer has disconnected.
+int get_send_flags() {
+#ifdef MSG_NOSIGNAL
+    return get_block_flags(false) | MSG_NOSIGNAL;
+#else
+    return get_block_flags(false);
+#endif
+}
+
+//Create a non-blocking loopback datagram socket connected to itself, such that other threads can interrupt waiting for sockets by sending to it.
+static int create_wake_socket() {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (sock < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        getsockname(sock, (struct sockaddr *)&addr, &len) != 0 ||
+        connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        !set_socket_blocking(sock, false)) {
+        close_socket_gen(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+//Discard all pending wake ups.
+static void drain_wake_socket(const int sock) {
+    char buffer[64];
+
+    while (recv(sock, buffer, sizeof(buffer), get_block_flags(false)) > 0);
+}
+
+//Receive data into the free part of the ring buffer directly following the buffered data, assuming the buffer is not full.
+static ssize_t client_receive(struct client *c, const int flags) {
+    //Start at the beginning of an empty buffer, such that reads are not split unnecessarily.
+    if (c->nr_buffer == 0) c->buffer_begin = 0;
+
+    const size_t end = (c->buffer_begin + c->nr_buffer) & (NR_NET_BUFFER - 1);
+    const size_t nr_free = (end < c->buffer_begin ? c->buffer_begin : NR_NET_BUFFER) - end;
+    const ssize_t n = recv(c->sock, (char *)(c->buffer + end), nr_free, flags);
+
+    if (n > 0) c->nr_buffer += n;
+
+    return n;
+}
+
+static size_t client_get_nr_queued(const struct client *c) {
+    return c->send_queue_end - c->send_queue_begin;
+}
+
+//Append data to the outbound queue of a client, growing it as necessary.
+static bool client_queue_data(struct client *c, const void *buffer, const size_t len) {
+    if (c->send_queue_end + len > c->send_queue_size) {
+        //Move queued data to the front to reuse sent space.
+        const size_t nr_queued = client_get_nr_queued(c);
+
+        if (nr_queued > 0) memmove(c->send_queue, c->send_queue + c->send_queue_begin, nr_queued);
+        c->send_queue_begin = 0;
+        c->send_queue_end = nr_queued;
+    }
+
+    if (c->send_queue_end + len > c->send_queue_size) {
+        size_t size = max(c->send_queue_size, (size_t)NR_NET_BUFFER);
+
+        while (size < c->send_queue_end + len) size *= 2;
+
+        uint8_t *queue = (uint8_t *)realloc(c->send_queue, size);
+
+        if (!queue) {
+            fprintf(ERROR_FILE, "client_queue_data: Unable to allocate %zu bytes!\n", size);
+            return false;
+        }
+
+        c->send_queue = queue;
+        c->send_queue_size = size;
+    }
+
+    memcpy(c->send_queue + c->send_queue_end, buffer, len);
+    c->send_queue_end += len;
+
+    return true;
+}
+
+//Send as much queued data as the socket accepts without blocking, returns false if the connection failed.
+static bool client_flush_queue(struct client *c) {
+    while (c->send_queue_begin < c->send_queue_end) {
+        const ssize_t nr_sent = send(c->sock, (const char *)(c->send_queue + c->send_queue_begin), c->send_queue_end - c->send_queue_begin, get_send_flags());
+
+        if (nr_sent < 0) {
+            if (socket_would_block()) return true;
+#ifdef _WIN32
+            fprintf(ERROR_FILE, "client_flush_queue: Unable to send data: %d!\n", WSAGetLastError());
+#else
+            fprintf(ERROR_FILE, "client_flush_queue: Unable to send data: %s!\n", strerror(errno));
+#endif
+            return false;
+        }
+
+        c->send_queue_begin += nr_sent;
+    }
+
+    c->send_queue_begin = c->send_queue_end = 0;
+
+    return true;
+}
+
 bool reset_client(void *_c) {
     if (!_c) {
         fprintf(ERROR_FILE, "reset_client: Invalid client!\n");
@@ -137,6 +298,7 @@ bool reset_client(void *_c) {
     struct client *c = (struct client *)_c;
 
     if (c->sock >= 0) close_socket_gen(c->sock);
+    if (c->send_queue) free(c->send_queue);
 
     memset(c, 0, sizeof(struct client));
     c->sock = -1;
@@ -323,21 +485,47 @@ bool client_listen(void *_c, const int time_out_ms) {
             fprintf(WARN_FILE, "client_listen: Client has non-processed data inside its buffer!\n");
         }
 
-        ssize_t n = recv(c->sock, (char *)(c->buffer + c->nr_buffer), NR_NET_BUFFER - c->nr_buffer, get_block_flags(c->blocking));
+        //Leave data in the socket until there is room for it.
+        if (c->nr_buffer >= NR_NET_BUFFER) return true;
+
+        ssize_t n = client_receive(c, get_block_flags(c->blocking));
         
         if (n <= 0) {
             fprintf(ERROR_FILE, "client_listen: Unable to receive data from host, closing connection!\n");
             reset_client(_c);
             return false;
         }
-        else {
-            c->nr_buffer += n;
-        }
     }
     
     return true;
 }
 
+//Block until the host sent data or the time out expires, without receiving anything.
+bool client_wait(void *_c, const int time_out_ms) {
+    struct client *c = (struct client *)_c;
+
+    if (!_c || c->sock < 0) {
+        fprintf(ERROR_FILE, "client_wait: Invalid client!\n");
+        return false;
+    }
+
+    fd_set read_fds, except_fds;
+    
+    FD_ZERO(&read_fds);
+    FD_ZERO(&except_fds);
+
+    FD_SET(c->sock, &read_fds);
+    FD_SET(c->sock, &except_fds);
+    
+    struct timeval tv;
+
+    tv.tv_sec = time_out_ms/1000;
+    tv.tv_usec = 1000*(time_out_ms % 1000);
+    
+    //Report errors as activity such that they are picked up by client_listen().
+    return (select(c->sock + 1, &read_fds, NULL, &except_fds, &tv) != 0);
+}
+
 bool client_send(void *_c, const void *buffer, size_t len) {
     struct client *c = (struct client *)_c;
 
@@ -410,16 +598,15 @@ size_t client_get_data(void *dest, void *_c, size_t nr) {
         return 0;
     }
 
-    //Copy data to external buffer.
-    memcpy(dest, c->buffer, nr);
+    //Copy data to external buffer, wrapping around the end of the ring buffer.
+    const size_t nr_first = min(nr, NR_NET_BUFFER - c->buffer_begin);
 
-    //Decrease size of client buffer and move remaining data to start of buffer.
-    c->nr_buffer -= nr;
+    memcpy(dest, c->buffer + c->buffer_begin, nr_first);
+    memcpy((uint8_t *)dest + nr_first, c->buffer, nr - nr_first);
 
-    if (c->nr_buffer > 0) {
-        memmove(c->buffer, c->buffer + nr, c->nr_buffer);
-        memset(c->buffer + c->nr_buffer, 0, nr);
-    }
+    //Release the data without moving the remainder.
+    c->buffer_begin = (c->buffer_begin + nr) & (NR_NET_BUFFER - 1);
+    c->nr_buffer -= nr;
 
     return nr;
 }
@@ -449,10 +636,15 @@ bool free_host(void **_h) {
     struct host *h = (struct host *)(*_h);
 
     if (h->clients) {
-        free_clients((void **)&h->clients, h->max_clients);
+        for (int i = 0; i < h->nr_client_slots; ++i) free_clients((void **)&h->clients[i], 1);
+        free(h->clients);
     }
 
     if (h->sock >= 0) close_socket_gen(h->sock);
+    if (h->wake_sock >= 0) close_socket_gen(h->wake_sock);
+#ifdef NET_USE_EPOLL
+    if (h->epoll_fd >= 0) close(h->epoll_fd);
+#endif
 
     free(*_h);
     *_h = NULL;
@@ -501,15 +693,31 @@ bool allocate_host(void **_h, const int port, const int max_clients) {
     
     memset(h, 0, sizeof(struct host));
     h->sock = -1;
+    h->wake_sock = -1;
+#ifdef NET_USE_EPOLL
+    h->epoll_fd = -1;
+#endif
     h->blocking = true;
     h->accepts_clients = 1;
     h->port = port;
 
+    //Client slots are allocated on demand when players connect.
     h->max_clients = max(1, max_clients);
+    h->nr_client_slots = 0;
+    h->clients = NULL;
     h->nr_clients = 0;
 
-    if (!allocate_clients((void **)&h->clients, h->max_clients)) {
-        fprintf(ERROR_FILE, "allocate_host: Unable to allocate clients!");
+#ifdef NET_USE_EPOLL
+    if ((h->epoll_fd = epoll_create1(0)) < 0) {
+        fprintf(ERROR_FILE, "allocate_host: Unable to create epoll instance: %s!\n", strerror(errno));
+        free_host(_h);
+        return false;
+    }
+#endif
+
+    if ((h->wake_sock = create_wake_socket()) < 0 || !host_watch_wake_socket(h)) {
+        fprintf(ERROR_FILE, "allocate_host: Unable to create wake up socket!\n");
+        free_host(_h);
         return false;
     }
     
@@ -531,6 +739,7 @@ bool allocate_host(void **_h, const int port, const int max_clients) {
     
     if (getaddrinfo(NULL, port_string, &info, &result) != 0) {
         fprintf(ERROR_FILE, "create_host: Unable to get address for port %d!\n", port);
+        free_host(_h);
         return false;
     }
 
@@ -585,7 +794,7 @@ bool allocate_host(void **_h, const int port, const int max_clients) {
             continue;
         }
 
-        if (listen(sock, 16) != 0) {
+        if (listen(sock, NR_NET_LISTEN_BACKLOG) != 0) {
 #ifdef _WIN32
             fprintf(ERROR_FILE, "create_host: Unable to listen at socket: %d!\n", WSAGetLastError());
 #else
@@ -602,7 +811,7 @@ bool allocate_host(void **_h, const int port, const int max_clients) {
 
     freeaddrinfo(result);
 
-    if (h->sock < 0) {
+    if (h->sock < 0 || !host_watch_socket(h, h->sock, -1)) {
         fprintf(ERROR_FILE, "create_host: Unable to listen at socket for incoming connections!\n");
         free_host(_h);
         return false;
@@ -613,6 +822,26 @@ bool allocate_host(void **_h, const int port, const int max_clients) {
     return true;
 }
 
+//Queue data for a client and start sending it, dropping the client if it cannot keep up.
+static bool host_queue_client(struct host *h, const int i, const void *buffer, const size_t len) {
+    struct client *c = h->clients[i];
+
+    if (client_get_nr_queued(c) + len > NR_NET_SEND_QUEUE_LIMIT) {
+        fprintf(WARN_FILE, "host_send: Dropping client '%s' port %d as it has %zu bytes of unsent data!\n", c->addr_text, c->port, client_get_nr_queued(c));
+        host_remove_client(h, i);
+        return false;
+    }
+
+    if (!client_queue_data(c, buffer, len) || !client_flush_queue(c)) {
+        host_remove_client(h, i);
+        return false;
+    }
+
+    host_watch_send(h, i);
+
+    return true;
+}
+
 bool host_send(void *_h, void *_c, const void *buffer, size_t len) {
     struct host *h = (struct host *)_h;
     struct client *c = (struct client *)_c;
@@ -621,38 +850,31 @@ bool host_send(void *_h, void *_c, const void *buffer, size_t len) {
         fprintf(ERROR_FILE, "host_send: Invalid host or client or buffer!\n");
         return false;
     }
-    
-    const uint8_t *buf = (const uint8_t *)buffer;
-    ssize_t nr_sent = 0;
-    
-    while (len > 0) {
-        if ((nr_sent = send(c->sock, (const char *)buf, len, get_block_flags(h->blocking))) < 0) {
-#ifdef _WIN32
-            fprintf(ERROR_FILE, "host_send: Unable to send data: %d!\n", WSAGetLastError());
-#else
-            fprintf(ERROR_FILE, "host_send: Unable to send data: %s!\n", strerror(errno));
-#endif
-            return false;
-        }
-        
-        buf += nr_sent;
-        len -= nr_sent;
-    }
 
-    return true;
+    int i = 0;
+
+    while (i < h->nr_client_slots && h->clients[i] != c) ++i;
+
+    if (i >= h->nr_client_slots) {
+        fprintf(ERROR_FILE, "host_send: Client does not belong to host!\n");
+        return false;
+    }
+    
+    return host_queue_client(h, i, buffer, len);
 }
     
 bool host_broadcast(void *_h, const void *buffer, const size_t len) {
     struct host *h = (struct host *)_h;
 
-    if (!_h || h->sock < 0 || !h->clients || !buffer || len == 0) {
+    if (!_h || h->sock < 0 || !buffer || len == 0) {
         fprintf(ERROR_FILE, "host_broadcast: Invalid host or buffer!\n");
         return false;
     }
 
-    for (int i = 0; i < h->max_clients; i++) {
-        if (h->clients[i].sock >= 0) {
-            if (!host_send(_h, (void *)&h->clients[i], buffer, len)) {
+    //Never wait for slow clients, they are dropped once their send queue is full.
+    for (int i = 0; i < h->nr_client_slots; i++) {
+        if (h->clients[i]->sock >= 0) {
+            if (!host_queue_client(h, i, buffer, len)) {
                 fprintf(WARN_FILE, "host_broadcast: Unable to send to client %d/%d!\n", i, h->max_clients);
             }
         }
@@ -661,32 +883,302 @@ bool host_broadcast(void *_h, const void *buffer, const size_t len) {
     return true;
 }
 
+//Get a free client slot, growing the client table if all slots are in use.
+static int host_get_free_client_slot(struct host *h) {
+    for (int i = 0; i < h->nr_client_slots; ++i) {
+        if (h->clients[i]->sock < 0) return i;
+    }
+
+    if (h->nr_client_slots >= h->max_clients) return -1;
+
+    const int i_free = h->nr_client_slots;
+
+    //Double the number of slots, such that growing to n clients takes O(n) time in total.
+    const int nr_slots = min(h->max_clients, max(NR_NET_MIN_CLIENT_SLOTS, 2*h->nr_client_slots));
+    struct client **clients = (struct client **)realloc(h->clients, nr_slots*sizeof(struct client *));
+
+    if (!clients) {
+        fprintf(ERROR_FILE, "host_get_free_client_slot: Unable to allocate %d client slots!\n", nr_slots);
+        return -1;
+    }
+
+    h->clients = clients;
+
+    for (int i = h->nr_client_slots; i < nr_slots; ++i) {
+        if (!allocate_clients((void **)&h->clients[i], 1)) {
+            fprintf(ERROR_FILE, "host_get_free_client_slot: Unable to allocate client!\n");
+            return -1;
+        }
+
+        //Only count fully allocated slots.
+        h->nr_client_slots = i + 1;
+    }
+
+    return (h->nr_client_slots > i_free ? i_free : -1);
+}
+
+//Accept a pending connection into a free client slot.
+static void host_accept_client(struct host *h) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    
+    memset(&addr, 0, sizeof(addr));
+
+    const int sock = accept(h->sock, (struct sockaddr *)&addr, &addr_len);
+
+    if (sock < 0) {
+        fprintf(ERROR_FILE, "host_listen: Unable to accept connection!\n");
+        return;
+    }
+    
+    const int i_client = (h->accepts_clients ? host_get_free_client_slot(h) : -1);
+
+    if (i_client < 0) {
+        fprintf(INFO_FILE, "host_listen: Unable to accept connection as we are at the maximum number of clients %d/%d or not accepting new clients!\n", h->nr_clients, h->max_clients);
+        close_socket_gen(sock);
+        return;
+    }
+
+#if !defined(NET_USE_EPOLL) && !defined(_WIN32)
+    //Sockets outside of the select() range cannot be watched.
+    if (sock >= FD_SETSIZE) {
+        fprintf(WARN_FILE, "host_listen: Unable to accept connection beyond FD_SETSIZE!\n");
+        close_socket_gen(sock);
+        return;
+    }
+#endif
+
+    struct client *c = h->clients[i_client];
+
+    memset(c, 0, sizeof(struct client));
+    c->sock = sock;
+    get_addr_string((const struct sockaddr *)&addr, c->addr_text, INET6_ADDRSTRLEN);
+    c->port = 0; //TODO: addr.sin6_port;
+    c->blocking = false;
+
+    if (!host_watch_socket(h, sock, i_client)) {
+        fprintf(ERROR_FILE, "host_listen: Unable to watch connection from '%s'!\n", c->addr_text);
+        close_socket_gen(sock);
+        c->sock = -1;
+        return;
+    }
+
+    //Client sockets never block, as outbound data is queued.
+    set_socket_blocking(sock, false);
+    set_socket_no_delay(sock);
+    c->newly_joined = 1;
+    h->nr_clients++;
+    fprintf(INFO_FILE, "Accepted connection from '%s' port %d, now at %d/%d clients.\n", c->addr_text, c->port, h->nr_clients, h->max_clients);
+}
+
+//Receive pending data from a client, or drop it if its connection failed.
+static void host_receive_client(struct host *h, const int i, const bool failed) {
+    struct client *c = h->clients[i];
+
+    if (c->sock < 0) return;
+
+    if (failed) {
+        //Client dropped or disconnected.
+        host_remove_client(h, i);
+        fprintf(INFO_FILE, "Connection closed from '%s' port %d, now at %d/%d clients.\n", c->addr_text, c->port, h->nr_clients, h->max_clients);
+        return;
+    }
+
+    //Previous client data should have been processed.
+    if (c->nr_buffer > 0) {
+        fprintf(WARN_FILE, "host_listen: Client has non-processed data inside its buffer!\n");
+    }
+
+    //Leave data in the socket until there is room for it.
+    if (c->nr_buffer >= NR_NET_BUFFER) return;
+
+    ssize_t n = client_receive(c, get_block_flags(false));
+    
+    if (n < 0 && socket_would_block()) return;
+
+    if (n <= 0) {
+        host_remove_client(h, i);
+        fprintf(ERROR_FILE, "host_listen: Unable to receive data from client!\n");
+        fprintf(INFO_FILE, "Connection closed from '%s' port %d, now at %d/%d clients.\n", c->addr_text, c->port, h->nr_clients, h->max_clients);
+    }
+}
+
+//Continue sending queued data to a client once its socket is writable.
+static void host_send_client(struct host *h, const int i) {
+    struct client *c = h->clients[i];
+
+    if (c->sock < 0) return;
+
+    if (!client_flush_queue(c)) {
+        host_remove_client(h, i);
+        fprintf(INFO_FILE, "Connection closed from '%s' port %d, now at %d/%d clients.\n", c->addr_text, c->port, h->nr_clients, h->max_clients);
+        return;
+    }
+
+    host_watch_send(h, i);
+}
+
+#ifdef NET_USE_EPOLL
+//Register a socket with the readiness set of the host, using index -1 for the listening socket.
+static bool host_watch_socket(struct host *h, const int sock, const int i) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)(i + 1);
+
+    return (epoll_ctl(h->epoll_fd, EPOLL_CTL_ADD, sock, &event) == 0);
+}
+
+static void host_unwatch_socket(struct host *h, const int sock) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    epoll_ctl(h->epoll_fd, EPOLL_CTL_DEL, sock, &event);
+}
+
+static bool host_watch_wake_socket(struct host *h) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = NET_WAKE_EVENT;
+
+    return (epoll_ctl(h->epoll_fd, EPOLL_CTL_ADD, h->wake_sock, &event) == 0);
+}
+
+//Only wait for a client socket to become writable while it has queued data.
+static void host_watch_send(struct host *h, const int i) {
+    struct client *c = h->clients[i];
+    const bool watch = (c->sock >= 0 && client_get_nr_queued(c) > 0);
+
+    if (watch == c->send_watched || c->sock < 0) return;
+
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | (watch ? EPOLLOUT : 0);
+    event.data.u64 = (uint64_t)(i + 1);
+
+    if (epoll_ctl(h->epoll_fd, EPOLL_CTL_MOD, c->sock, &event) == 0) c->send_watched = watch;
+}
+
 bool host_listen(void *_h, const int time_out_ms) {
     struct host *h = (struct host *)_h;
 
-    if (!_h || h->sock < 0 || !h->clients) {
+    if (!_h || h->sock < 0) {
         fprintf(ERROR_FILE, "host_listen: Invalid or non-listening host!\n");
         return false;
     }
     
-    fd_set read_fds, write_fds, except_fds;
-    int max_fd = h->sock;
+    //Only visit sockets that are ready, instead of scanning all clients.
+    struct epoll_event events[NR_NET_EPOLL_EVENTS];
+    const int nr_events = epoll_wait(h->epoll_fd, events, NR_NET_EPOLL_EVENTS, time_out_ms);
+
+    if (nr_events < 0) {
+        if (errno == EINTR) return true;
+
+        fprintf(ERROR_FILE, "host_listen: Unable to run epoll_wait(): %s!\n", strerror(errno));
+        return false;
+    }
+
+    for (int i_event = 0; i_event < nr_events; ++i_event) {
+        if (events[i_event].data.u64 == NET_WAKE_EVENT) continue;
+
+        const int i = (int)events[i_event].data.u64 - 1;
+        const bool failed = ((events[i_event].events & (EPOLLERR | EPOLLHUP)) != 0);
+
+        if (i < 0) {
+            if (failed) {
+                fprintf(ERROR_FILE, "host_listen: Exception at host socket!\n");
+                return false;
+            }
+
+            host_accept_client(h);
+        }
+        else if (i < h->nr_client_slots) {
+            //Read pending data before handling hang-ups, such that final messages are not lost.
+            host_receive_client(h, i, failed && (events[i_event].events & EPOLLIN) == 0);
+            if (events[i_event].events & EPOLLOUT) host_send_client(h, i);
+        }
+    }
+
+    return true;
+}
+
+//Block until a client sent data, a new connection arrived, the time out expires, or host_interrupt() is called, without accepting or receiving anything. Returns whether there was network activity.
+bool host_wait(void *_h, const int time_out_ms) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || h->sock < 0) {
+        fprintf(ERROR_FILE, "host_wait: Invalid or non-listening host!\n");
+        return false;
+    }
     
-    FD_ZERO(&read_fds);
-    FD_ZERO(&write_fds);
-    FD_ZERO(&except_fds);
+    //Sockets remain ready until read from, so host_listen() will see the same events.
+    //As only the wake up socket is not a network socket, two events suffice to tell whether there is network activity.
+    struct epoll_event events[2];
+    const int nr_events = epoll_wait(h->epoll_fd, events, 2, time_out_ms);
+    int nr_wake_events = 0;
+
+    for (int i_event = 0; i_event < nr_events; ++i_event) {
+        if (events[i_event].data.u64 == NET_WAKE_EVENT) nr_wake_events++;
+    }
+
+    if (nr_wake_events > 0) drain_wake_socket(h->wake_sock);
 
-    FD_SET(h->sock, &read_fds);
-    FD_SET(h->sock, &except_fds);
+    //Report errors as activity such that they are picked up by host_listen().
+    return (nr_events < 0 || nr_events > nr_wake_events);
+}
+#else
+//Without epoll sockets are gathered from the client table for every select() call.
+static bool host_watch_socket(struct host *UNUSED(h), const int UNUSED(sock), const int UNUSED(i)) {
+    return true;
+}
 
-    for (int i = 0; i < h->max_clients; ++i) {
-        if (h->clients[i].sock >= 0) {
-            max_fd = max(max_fd, h->clients[i].sock);
-            FD_SET(h->clients[i].sock, &read_fds);
-            FD_SET(h->clients[i].sock, &write_fds);
+static void host_unwatch_socket(struct host *UNUSED(h), const int UNUSED(sock)) {
+}
+
+static void host_watch_send(struct host *UNUSED(h), const int UNUSED(i)) {
+}
+
+static bool host_watch_wake_socket(struct host *UNUSED(h)) {
+    return true;
+}
+
+//Gather the sockets of the host and all its clients, including those with queued data for writing, returning the largest socket.
+static int host_get_fd_set(struct host *h, fd_set *read_fds, fd_set *write_fds, fd_set *except_fds) {
+    int max_fd = h->sock;
+    
+    FD_ZERO(read_fds);
+    FD_ZERO(write_fds);
+    FD_ZERO(except_fds);
+
+    FD_SET(h->sock, read_fds);
+    FD_SET(h->sock, except_fds);
+
+    for (int i = 0; i < h->nr_client_slots; ++i) {
+        if (h->clients[i]->sock >= 0) {
+            max_fd = max(max_fd, h->clients[i]->sock);
+            FD_SET(h->clients[i]->sock, read_fds);
+            FD_SET(h->clients[i]->sock, except_fds);
+            if (client_get_nr_queued(h->clients[i]) > 0) FD_SET(h->clients[i]->sock, write_fds);
         }
     }
 
+    return max_fd;
+}
+
+bool host_listen(void *_h, const int time_out_ms) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || h->sock < 0) {
+        fprintf(ERROR_FILE, "host_listen: Invalid or non-listening host!\n");
+        return false;
+    }
+    
+    fd_set read_fds, write_fds, except_fds;
+    const int max_fd = host_get_fd_set(h, &read_fds, &write_fds, &except_fds);
     struct timeval tv;
 
     tv.tv_sec = time_out_ms/1000;
@@ -703,100 +1195,96 @@ bool host_listen(void *_h, const int time_out_ms) {
         return false;
     }
     
-    //Any new connections?
-    if (FD_ISSET(h->sock, &read_fds)) {
-        if (!h->accepts_clients || h->nr_clients >= h->max_clients) {
-            fprintf(INFO_FILE, "host_listen: Unable to accept connection as we are at the maximum number of clients %d/%d or not accepting new clients!\n", h->nr_clients, h->max_clients);
+    //Any data from the clients? Checked before accepting, as new clients were not part of the select() call.
+    for (int i = 0; i < h->nr_client_slots; ++i) {
+        const int sock = h->clients[i]->sock;
+
+        if (sock >= 0 && (FD_ISSET(sock, &except_fds) || FD_ISSET(sock, &read_fds))) {
+            host_receive_client(h, i, FD_ISSET(sock, &except_fds));
         }
-        else {
-            int i_client;
-            
-            for (i_client = 0; i_client < h->max_clients; i_client++) {
-                if (h->clients[i_client].sock < 0) break;
-            }
 
-            if (i_client >= h->max_clients) {
-                fprintf(ERROR_FILE, "host_listen: This should never happen!\n");
-                return false;
-            }
+        if (sock >= 0 && FD_ISSET(sock, &write_fds)) host_send_client(h, i);
+    }
 
-            memset(&h->clients[i_client], 0, sizeof(struct client));
-            
-            struct sockaddr_storage addr;
-            socklen_t addr_len = sizeof(addr);
-            
-            memset(&addr, 0, sizeof(addr));
-            h->clients[i_client].sock = accept(h->sock, (struct sockaddr *)&addr, &addr_len);
-            get_addr_string((const struct sockaddr *)&addr, h->clients[i_client].addr_text, INET6_ADDRSTRLEN);
-            h->clients[i_client].port = 0; //TODO: addr.sin6_port;
-            h->clients[i_client].newly_joined = 0;
-
-            if (h->clients[i_client].sock == -1) {
-                fprintf(ERROR_FILE, "host_listen: Unable to accept connection from '%s' port %d!\n", h->clients[i_client].addr_text, h->clients[i_client].port);
-            }
-            else {
-                set_socket_blocking(h->clients[i_client].sock, h->blocking);
-                set_socket_no_delay(h->clients[i_client].sock);
-                h->clients[i_client].newly_joined = 1;
-                h->nr_clients++;
-                fprintf(INFO_FILE, "Accepted connection from '%s' port %d, now at %d/%d clients.\n", h->clients[i_client].addr_text, h->clients[i_client].port, h->nr_clients, h->max_clients);
-            }
-        }
+    //Any new connections?
+    if (FD_ISSET(h->sock, &read_fds)) host_accept_client(h);
+
+    return true;
+}
+
+//Block until a client sent data, a new connection arrived, the time out expires, or host_interrupt() is called, without accepting or receiving anything. Returns whether there was network activity.
+bool host_wait(void *_h, const int time_out_ms) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || h->sock < 0) {
+        fprintf(ERROR_FILE, "host_wait: Invalid or non-listening host!\n");
+        return false;
     }
+    
+    fd_set read_fds, write_fds, except_fds;
+    const int max_fd = max(host_get_fd_set(h, &read_fds, &write_fds, &except_fds), h->wake_sock);
+    struct timeval tv;
 
-    //Any data from the clients?
-    for (int i = 0; i < h->max_clients; ++i) {
-        if (h->clients[i].sock >= 0) {
-            if (FD_ISSET(h->clients[i].sock, &except_fds)) {
-                //Client dropped or disconnected.
-                host_remove_client(h, i);
-                fprintf(INFO_FILE, "Connection closed from '%s' port %d, now at %d/%d clients.\n", h->clients[i].addr_text, h->clients[i].port, h->nr_clients, h->max_clients);
-            }
-            else if (FD_ISSET(h->clients[i].sock, &read_fds)) {
-                //Client has data.
-
-                //Previous client data should have been processed.
-                if (h->clients[i].nr_buffer > 0) {
-                    fprintf(WARN_FILE, "host_listen: Client has non-processed data inside its buffer!\n");
-                }
-
-                ssize_t n = recv(h->clients[i].sock, (char *)(h->clients[i].buffer + h->clients[i].nr_buffer), NR_NET_BUFFER - h->clients[i].nr_buffer, get_block_flags(h->blocking));
-                
-                if (n <= 0) {
-                    host_remove_client(h, i);
-                    fprintf(ERROR_FILE, "host_listen: Unable to receive data from client!\n");
-                    fprintf(INFO_FILE, "Connection closed from '%s' port %d, now at %d/%d clients.\n", h->clients[i].addr_text, h->clients[i].port, h->nr_clients, h->max_clients);
-                }
-                else {
-                    h->clients[i].nr_buffer += n;
-                }
-            }
-        }
+    FD_SET(h->wake_sock, &read_fds);
+    tv.tv_sec = time_out_ms/1000;
+    tv.tv_usec = 1000*(time_out_ms % 1000);
+    
+    const int nr_ready = select(max_fd + 1, &read_fds, &write_fds, &except_fds, &tv);
+    const int nr_wake_ready = (nr_ready > 0 && FD_ISSET(h->wake_sock, &read_fds) ? 1 : 0);
+
+    if (nr_wake_ready > 0) drain_wake_socket(h->wake_sock);
+
+    //Report errors as activity such that they are picked up by host_listen().
+    return (nr_ready < 0 || nr_ready > nr_wake_ready);
+}
+#endif
+
+//Make a host_wait() call in progress on another thread return, or the next one if none is in progress.
+bool host_interrupt(void *_h) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || h->wake_sock < 0) {
+        fprintf(ERROR_FILE, "host_interrupt: Invalid host!\n");
+        return false;
     }
 
-    return true;
+    const char wake = 1;
+
+    //A full socket buffer means a wake up is already pending.
+    return (send(h->wake_sock, &wake, 1, get_send_flags()) == 1 || socket_would_block());
 }
 
 bool host_remove_client(void *_h, const int i) {
     struct host *h = (struct host *)_h;
 
-    if (!_h || i < 0 || i >= h->max_clients) {
+    if (!_h || i < 0 || i >= h->nr_client_slots) {
         fprintf(ERROR_FILE, "host_remove_client: Invalid host or client index!\n");
         return false;
     }
     
-    if (h->clients[i].sock >= 0) {
+    struct client *c = h->clients[i];
+
+    if (c->sock >= 0) {
         h->nr_clients--;
-        close_socket_gen(h->clients[i].sock);
+        host_unwatch_socket(h, c->sock);
+        close_socket_gen(c->sock);
     }
     else {
         fprintf(WARN_FILE, "host_remove_client: Removing an already removed client!\n");
     }
 
-    h->clients[i].sock = -1;
-    h->clients[i].newly_joined = 0;
+    c->sock = -1;
+    c->newly_joined = 0;
+    c->buffer_begin = 0;
+    c->nr_buffer = 0;
+
+    //Discard unsent data.
+    if (c->send_queue) free(c->send_queue);
+    c->send_queue = NULL;
+    c->send_queue_size = c->send_queue_begin = c->send_queue_end = 0;
+    c->send_watched = false;
 
-    fprintf(INFO_FILE, "Removed client %s port %d.\n", h->clients[i].addr_text, h->clients[i].port);
+    fprintf(INFO_FILE, "Removed client %s port %d.\n", c->addr_text, c->port);
     
     return true;
 }
@@ -819,8 +1307,11 @@ bool host_is_client_active(void *_h, const int i) {
         fprintf(WARN_FILE, "host_is_client_active: Invalid host or client index!\n");
         return false;
     }
+
+    //Slots that were never needed have no client.
+    if (i >= h->nr_client_slots) return false;
     
-    return client_is_client_active((void *)&h->clients[i]);
+    return client_is_client_active((void *)h->clients[i]);
 }
 
 bool host_is_client_new(void *_h, const int i) {
@@ -831,7 +1322,9 @@ bool host_is_client_new(void *_h, const int i) {
         return false;
     }
 
-    return client_is_client_new((void *)&h->clients[i]);
+    if (i >= h->nr_client_slots) return false;
+
+    return client_is_client_new((void *)h->clients[i]);
 }
 
 bool host_set_blocking(void *_h, const bool blocking) {
@@ -849,14 +1342,7 @@ bool host_set_blocking(void *_h, const bool blocking) {
         return false;
     }
 
-    for (int i = 0; i < h->max_clients; ++i) {
-        if (h->clients[i].sock >= 0) {
-            if (!set_socket_blocking(h->clients[i].sock, blocking)) {
-                fprintf(WARN_FILE, "host_set_blocking: Unable to change client socket state!\n");
-            }
-        }
-    }
-
+    //Client sockets remain non-blocking, as data sent to them is queued.
     return true;
 }
 
@@ -880,12 +1366,12 @@ int host_get_active_client_index(void *_h, int i) {
         return -1;
     }
 
-    if (i < 0 || i >= h->max_clients) {
+    if (i < 0 || i >= h->nr_client_slots) {
         return -1;
     }
 
-    for ( ; i < h->max_clients; ++i) {
-        if (client_is_client_active((void *)&h->clients[i])) {
+    for ( ; i < h->nr_client_slots; ++i) {
+        if (client_is_client_active((void *)h->clients[i])) {
             return i;
         }
     }
@@ -893,15 +1379,27 @@ int host_get_active_client_index(void *_h, int i) {
     return -1;
 }
 
+size_t host_get_nr_queued(void *_h, void *_c) {
+    struct host *h = (struct host *)_h;
+    struct client *c = (struct client *)_c;
+
+    if (!_h || h->sock < 0 || !_c) {
+        fprintf(ERROR_FILE, "host_get_nr_queued: Invalid host or client!\n");
+        return 0;
+    }
+
+    return client_get_nr_queued(c);
+}
+
 void *host_get_client(void *_h, int i) {
     struct host *h = (struct host *)_h;
 
-    if (!_h || h->sock < 0 || i < 0 || i >= h->max_clients) {
+    if (!_h || h->sock < 0 || i < 0 || i >= h->nr_client_slots) {
         fprintf(ERROR_FILE, "host_get_client: Invalid host or client index!\n");
         return NULL;
     }
 
-    return (void *)&h->clients[i];
+    return (void *)h->clients[i];
 }
 
 void host_fprintf(FILE *file, void *_h) {
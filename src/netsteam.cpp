@@ -12,6 +12,8 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <atomic>
 
 #include <steam/isteamnetworkingsockets.h>
 #include <steam/isteamnetworkingutils.h>
@@ -34,7 +36,13 @@ extern "C" {
 #define NR_CLIENT_STEAM_MESSAGES 32
 #define NR_HOST_STEAM_MESSAGES 128
 
-//The buffer size of a network client.
+//The Steam host keeps a fixed client table, so limit its size.
+#define MAX_NET_STEAM_CLIENTS 64
+
+//The time in milliseconds we sleep at most before polling for messages again while waiting.
+#define NET_STEAM_WAIT_MS 10
+
+//The buffer size of a network client, a power of two.
 #define NR_NET_BUFFER 65536
 
 struct client {
@@ -42,6 +50,7 @@ struct client {
     int port;
     HSteamNetConnection sock;
     uint8_t buffer[NR_NET_BUFFER + 1];
+    size_t buffer_begin; /**< Position of the first received byte in the ring buffer. */
     size_t nr_buffer;
     bool newly_joined;
     bool blocking;
@@ -66,6 +75,8 @@ struct host {
     bool accepts_clients;
     bool blocking;
     bool active;
+    bool connections_changed; /**< Whether a client connected or disconnected since the last host_wait(). */
+    std::atomic<bool> interrupted; /**< Set by host_interrupt() to make host_wait() return. */
 
     STEAM_CALLBACK(host, OnNetConnectionStatusChanged, SteamNetConnectionStatusChangedCallback_t);
     STEAM_CALLBACK(host, OnIPCFailure, IPCFailure_t);
@@ -116,11 +127,26 @@ bool reset_client(void *_c) {
     c->blocking = true;
     c->active = false;
     c->callbacks = false;
+    c->buffer_begin = 0;
     c->nr_buffer = 0;
 
     return true;
 }
 
+//Append a received message to the ring buffer of a client.
+static bool client_append_data(struct client *c, const uint8_t *data, const size_t nr) {
+    if (nr + c->nr_buffer > NR_NET_BUFFER) return false;
+
+    const size_t end = (c->buffer_begin + c->nr_buffer) & (NR_NET_BUFFER - 1);
+    const size_t nr_first = std::min(nr, NR_NET_BUFFER - end);
+
+    memcpy(c->buffer + end, data, nr_first);
+    memcpy(c->buffer, data + nr_first, nr - nr_first);
+    c->nr_buffer += nr;
+
+    return true;
+}
+
 extern "C" bool __cdecl allocate_clients(void **_c, const size_t nr_clients) {
     if (!_c) {
         fprintf(ERROR_FILE, "allocate_clients: Invalid memory address!\n");
@@ -300,6 +326,27 @@ void client::OnSteamShutdown(SteamShutdown_t *callback) {
     reset_client(this);
 }
 
+//Append all messages from the host to the client buffer, returning the number of messages or -1 on failure.
+static int client_receive_messages(struct client *c) {
+    SteamNetworkingMessage_t *messages[NR_CLIENT_STEAM_MESSAGES];
+	const int nr_messages = SteamGameServerNetworkingSockets()->ReceiveMessagesOnConnection(c->sock, messages, NR_CLIENT_STEAM_MESSAGES);
+    bool result = true;
+	
+    for (int i_msg = 0; i_msg < nr_messages; ++i_msg) {
+        SteamNetworkingMessage_t *message = messages[i_msg];
+        
+        //Append data to client buffer.
+        if (result && !client_append_data(c, (const uint8_t *)message->GetData(), message->GetSize())) {
+            fprintf(ERROR_FILE, "client_receive_messages: Unable to receive message of size %u from host!\n", message->GetSize());
+            result = false;
+        }
+
+        message->Release();
+    }
+
+    return (result ? nr_messages : -1);
+}
+
 extern "C" bool __cdecl client_listen(void *_c, const int) {
     struct client *c = (struct client *)_c;
 
@@ -312,26 +359,27 @@ extern "C" bool __cdecl client_listen(void *_c, const int) {
     SteamNetworkingSockets()->RunCallbacks();
 
     //Any data from the host?
-    SteamNetworkingMessage_t *messages[NR_CLIENT_STEAM_MESSAGES];
-	const int nr_messages = SteamGameServerNetworkingSockets()->ReceiveMessagesOnConnection(c->sock, messages, NR_CLIENT_STEAM_MESSAGES);
-	
-    for (int i_msg = 0; i_msg < nr_messages; ++i_msg) {
-        SteamNetworkingMessage_t *message = messages[i_msg];
-        
-        //Append data to client buffer.
-        if (message->GetSize() + c->nr_buffer <= NR_NET_BUFFER) {
-            memcpy(c->buffer + c->nr_buffer, message->GetData(), message->GetSize());
-            c->nr_buffer += message->GetSize();
-        }
-        else {
-            fprintf(ERROR_FILE, "client_listen: Unable to receive message of size %u from host!\n", message->GetSize());
-            return false;
-        }
+    return (!c->active || client_receive_messages(c) >= 0);
+}
 
-        message->Release();
+//Steam networking offers no blocking wait, so poll for messages between short sleeps. Received messages are kept in the client buffer for client_listen(). Returns whether there was network activity.
+extern "C" bool __cdecl client_wait(void *_c, const int time_out_ms) {
+    struct client *c = (struct client *)_c;
+
+    if (!_c || !c->active) {
+        fprintf(ERROR_FILE, "client_wait: Invalid client!\n");
+        return false;
     }
 
-    return true;
+    for (int t = 0; ; t += NET_STEAM_WAIT_MS) {
+        SteamNetworkingSockets()->RunCallbacks();
+
+        //Let the caller notice a lost connection or failure.
+        if (!c->active || client_receive_messages(c) != 0) return true;
+        if (t >= time_out_ms) return false;
+
+        usleep(1000*std::min(time_out_ms - t, NET_STEAM_WAIT_MS));
+    }
 }
 
 extern "C" bool __cdecl client_send(void *_c, const void *buffer, size_t len) {
@@ -373,16 +421,15 @@ extern "C" size_t __cdecl client_get_data(void *dest, void *_c, size_t nr) {
         return 0;
     }
 
-    //Copy data to external buffer.
-    memcpy(dest, c->buffer, nr);
+    //Copy data to external buffer, wrapping around the end of the ring buffer.
+    const size_t nr_first = std::min(nr, NR_NET_BUFFER - c->buffer_begin);
 
-    //Decrease size of client buffer and move remaining data to start of buffer.
-    c->nr_buffer -= nr;
+    memcpy(dest, c->buffer + c->buffer_begin, nr_first);
+    memcpy((uint8_t *)dest + nr_first, c->buffer, nr - nr_first);
 
-    if (c->nr_buffer > 0) {
-        memmove(c->buffer, c->buffer + nr, c->nr_buffer);
-        memset(c->buffer + c->nr_buffer, 0, nr);
-    }
+    //Release the data without moving the remainder.
+    c->buffer_begin = (c->buffer_begin + nr) & (NR_NET_BUFFER - 1);
+    c->nr_buffer -= nr;
 
     return nr;
 }
@@ -451,12 +498,13 @@ extern "C" bool __cdecl allocate_host(void **_h, const int port, const int max_c
 
     alloc.construct(h);
     
+    h->interrupted = false;
     h->blocking = true;
     h->accepts_clients = true;
     h->port = port;
     h->active = false;
     
-    h->max_clients = max(1, max_clients);
+    h->max_clients = max(1, min(max_clients, MAX_NET_STEAM_CLIENTS));
     h->nr_clients = 0;
     h->sock = k_HSteamNetConnection_Invalid;
 
@@ -511,6 +559,8 @@ extern "C" bool __cdecl allocate_host(void **_h, const int port, const int max_c
 }
 
 void host::OnNetConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t *callback) {
+    this->connections_changed = true;
+
     //Any new connecting clients?
     if (callback->m_info.m_hListenSocket &&
         callback->m_eOldState == k_ESteamNetworkingConnectionState_None &&
@@ -586,18 +636,8 @@ void host::OnSteamShutdown(SteamShutdown_t *callback) {
     this->active = false;
 }
 
-extern "C" bool __cdecl host_listen(void *_h, const int) {
-    struct host *h = (struct host *)_h;
-
-    if (!_h || !h->active) {
-        fprintf(ERROR_FILE, "host_listen: Invalid host!\n");
-        return false;
-    }
-
-    //Any new or dropped connections are handled by STEAM_GAMESERVER_CALLBACK().
-    SteamGameServer_RunCallbacks();
-
-    //Any data from clients?
+//Append all messages from clients to their buffers, returning the number of messages.
+static int host_receive_messages(struct host *h) {
     SteamNetworkingMessage_t *messages[NR_HOST_STEAM_MESSAGES];
 	const int nr_messages = SteamGameServerNetworkingSockets()->ReceiveMessagesOnPollGroup(h->poll_group, messages, NR_HOST_STEAM_MESSAGES);
 	
@@ -608,12 +648,8 @@ extern "C" bool __cdecl host_listen(void *_h, const int) {
         //Append data to client buffer.
         for (int i_cli = 0; i_cli < h->max_clients; ++i_cli) {
             if (h->clients[i_cli].active && h->clients[i_cli].id == client_id) {
-                if (message->GetSize() + h->clients[i_cli].nr_buffer <= NR_NET_BUFFER) {
-                    memcpy(h->clients[i_cli].buffer + h->clients[i_cli].nr_buffer, message->GetData(), message->GetSize());
-                    h->clients[i_cli].nr_buffer += message->GetSize();
-                }
-                else {
-                    fprintf(ERROR_FILE, "host_listen: Unable to receive message of size %u from client %d!\n", message->GetSize(), i_cli);
+                if (!client_append_data(&h->clients[i_cli], (const uint8_t *)message->GetData(), message->GetSize())) {
+                    fprintf(ERROR_FILE, "host_receive_messages: Unable to receive message of size %u from client %d!\n", message->GetSize(), i_cli);
                 }
             }
         }
@@ -621,6 +657,60 @@ extern "C" bool __cdecl host_listen(void *_h, const int) {
         message->Release();
     }
 
+    return nr_messages;
+}
+
+extern "C" bool __cdecl host_listen(void *_h, const int) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || !h->active) {
+        fprintf(ERROR_FILE, "host_listen: Invalid host!\n");
+        return false;
+    }
+
+    //Any new or dropped connections are handled by STEAM_GAMESERVER_CALLBACK().
+    SteamGameServer_RunCallbacks();
+
+    //Any data from clients?
+    host_receive_messages(h);
+
+    return true;
+}
+
+//Steam networking offers no blocking wait, so poll for connections and messages between short sleeps. Received messages are kept in the client buffers for host_listen(). Returns whether there was network activity.
+extern "C" bool __cdecl host_wait(void *_h, const int time_out_ms) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || !h->active) {
+        fprintf(ERROR_FILE, "host_wait: Invalid host!\n");
+        return false;
+    }
+
+    h->connections_changed = false;
+
+    for (int t = 0; ; t += NET_STEAM_WAIT_MS) {
+        if (h->interrupted.exchange(false)) return false;
+
+        SteamGameServer_RunCallbacks();
+
+        if (!h->active || h->connections_changed || host_receive_messages(h) > 0) return true;
+        if (t >= time_out_ms) return false;
+
+        usleep(1000*std::min(time_out_ms - t, NET_STEAM_WAIT_MS));
+    }
+}
+
+//Make a host_wait() call in progress on another thread return, or the next one if none is in progress.
+extern "C" bool __cdecl host_interrupt(void *_h) {
+    struct host *h = (struct host *)_h;
+
+    if (!_h || !h->active) {
+        fprintf(ERROR_FILE, "host_interrupt: Invalid host!\n");
+        return false;
+    }
+
+    h->interrupted = true;
+
     return true;
 }
 
@@ -745,6 +835,22 @@ extern "C" int __cdecl host_get_active_client_index(void *_h, int i) {
     return -1;
 }
 
+extern "C" size_t __cdecl host_get_nr_queued(void *_h, void *_c) {
+    struct host *h = (struct host *)_h;
+    struct client *c = (struct client *)_c;
+    
+    if (!_h || !h->active || !_c || !c->active) {
+        fprintf(ERROR_FILE, "host_get_nr_queued: Invalid host or client!\n");
+        return 0;
+    }
+
+    SteamNetConnectionRealTimeStatus_t status;
+
+    if (SteamNetworkingSockets()->GetConnectionRealTimeStatus(c->sock, &status, 0, nullptr) != k_EResultOK) return 0;
+
+    return (size_t)status.m_cbPendingReliable;
+}
+
 extern "C" void __cdecl *host_get_client(void *_h, int i) {
     struct host *h = (struct host *)_h;
 
@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License along with Ret
 
 #include "retrogauntlet.h"
 #include "stringextra.h"
+#include "files.h"
 #include "net.h"
 #include "blowfish.h"
 #include "glcheck.h"
@@ -65,6 +66,9 @@ uintptr_t env_get_current_framebuffer() {
 }
 
 bool env_set_hw_render(struct retro_hw_render_callback *cb) {
+    //Hardware rendering is impossible without a window and OpenGL context.
+    if (!_rg_state.window) return false;
+
     if (cb->context_type != RETRO_HW_CONTEXT_OPENGL &&
         cb->context_type != RETRO_HW_CONTEXT_OPENGL_CORE) {
         return false;
@@ -186,10 +190,26 @@ bool env_get_perf_interface(struct retro_perf_callback *cb) {
     return true;
 }
 
+bool env_set_geometry(const struct retro_game_geometry *geometry) {
+    //The emulation thread has no OpenGL context, so the render thread applies the geometry.
+    if (_rg_state.emulation_threaded) {
+        _rg_state.emulation_geometry = *geometry;
+        SDL_AtomicSet(&_rg_state.emulation_geometry_changed, 1);
+        return true;
+    }
+
+    return video_set_geometry(&_rg_state.sgci.video, geometry);
+}
+
 bool env_set_system_av_info(struct retro_system_av_info *info) {
-    video_set_geometry(&_rg_state.sgci.video, &info->geometry);
+    env_set_geometry(&info->geometry);
+    
+    //Restart the emulation thread to resize its frames and timing.
+    if (_rg_state.emulation_threaded) SDL_AtomicSet(&_rg_state.emulation_quit, 1);
+    
     _rg_state.sgci.core.frames_per_second = info->timing.fps;
     _rg_state.sgci.core.sample_rate = info->timing.sample_rate;
+    if (_rg_state.sgci.audio_device_id && info->timing.sample_rate > 0.0) _rg_state.sgci.audio_resampler.ratio = (double)_rg_state.sgci.audio_spec.freq/info->timing.sample_rate;
     return true;
 }
 
@@ -301,8 +321,7 @@ bool setup_sdl_opengl_environment(unsigned cmd, void *data) {
         case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
             return env_set_system_av_info((struct retro_system_av_info *)data);
         case RETRO_ENVIRONMENT_SET_GEOMETRY:
-            video_set_geometry(&_rg_state.sgci.video, (struct retro_game_geometry *)data);
-            return true;
+            return env_set_geometry((struct retro_game_geometry *)data);
         case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
             return env_set_controller_info((struct retro_controller_info *)data);
         case RETRO_ENVIRONMENT_GET_USERNAME:
@@ -316,8 +335,8 @@ bool setup_sdl_opengl_environment(unsigned cmd, void *data) {
         case RETRO_ENVIRONMENT_GET_LED_INTERFACE:
             return env_get_led_interface((struct retro_led_interface *)data);
         case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
-            *(int *)data = 1 | 2;
-            //FIXME: Fast save states 4?
+            //Let the core skip rendering for frames we run to catch up or run ahead.
+            *(int *)data = (_rg_state.sgci.core_skip_video ? 0 : 1) | (_rg_state.sgci.core_skip_audio ? 0 : 2) | (_rg_state.sgci.core_fast_states ? 4 : 0);
             return true;
         case RETRO_ENVIRONMENT_GET_FASTFORWARDING:
             *(bool *)data = false;
@@ -359,10 +378,19 @@ bool setup_sdl_opengl_environment(unsigned cmd, void *data) {
 }
 
 void sdl_opengl_video_refresh(const void *data, unsigned width, unsigned height, size_t pitch) {
+    if (_rg_state.sgci.core_skip_video) return;
+    
+    //Hand frames to the render thread, NULL data repeats the previous frame.
+    if (_rg_state.emulation_threaded) {
+        if (data && data != RETRO_HW_FRAME_BUFFER_VALID) video_triple_buffer_write(&_rg_state.emulation_frames, data, width, height, pitch, _rg_state.sgci.video.bytes_per_pixel);
+        return;
+    }
+    
     video_refresh_from_libretro(&_rg_state.sgci.video, data, width, height, pitch);
 }
 
 size_t sdl_audio_sample_batch(const int16_t *data, size_t frames) {
+    if (_rg_state.sgci.core_skip_audio) return frames;
     audio_refresh(&_rg_state.sgci, data, frames);
     return 0;
 }
@@ -385,10 +413,22 @@ int16_t sdl_input_state(unsigned port, unsigned device, unsigned UNUSED(index),
     return sdl_gl_if_get_input_state(&_rg_state.sgci, device, id);
 }
 
+//Null sinks for headless benchmarking.
+void null_video_refresh(const void *UNUSED(data), unsigned UNUSED(width), unsigned UNUSED(height), size_t UNUSED(pitch)) {
+}
+
+size_t null_audio_sample_batch(const int16_t *UNUSED(data), size_t frames) {
+    return frames;
+}
+
+void null_audio_sample(int16_t UNUSED(left), int16_t UNUSED(right)) {
+}
+
 bool setup_sdl_app_for_gauntlet(const struct gauntlet *g) {
     //Initialize app for libretro.
     if (!create_sdl_gl_if(&_rg_state.sgci)) return false;
 
+    _rg_state.sgci.audio_latency_target = _rg_state.menu.audio_latency;
     video_set_window(&_rg_state.sgci.video, _rg_state.menu.video.window_width, _rg_state.menu.video.window_height);
     
     //Load libretro core and ROM.
@@ -401,6 +441,9 @@ bool setup_sdl_app_for_gauntlet(const struct gauntlet *g) {
             sdl_input_poll,
             sdl_input_state)) return false;
     
+    //Use SIMD kernels for memory inspection when available.
+    _rg_state.sgci.core.cpu_features = core_get_cpu_features();
+    
     //Create video/audio buffers necessary for the current core.
     if (!sdl_gl_if_create_core_buffers(&_rg_state.sgci)) return false;
 
@@ -410,6 +453,127 @@ bool setup_sdl_app_for_gauntlet(const struct gauntlet *g) {
     return true;
 }
 
+bool setup_headless_app_for_gauntlet(const struct gauntlet *g) {
+    //Initialize app for libretro without video or audio output.
+    if (!create_sdl_gl_if(&_rg_state.sgci)) return false;
+
+    if (!load_core_from_file(&_rg_state.sgci.core,
+            g->core_library_file, g->rom_file, g->core_variables_file,
+            setup_sdl_opengl_environment,
+            null_video_refresh,
+            null_audio_sample,
+            null_audio_sample_batch,
+            sdl_input_poll,
+            sdl_input_state)) return false;
+    
+    _rg_state.sgci.core.cpu_features = core_get_cpu_features();
+    
+    return sdl_gl_if_create_headless_core_buffers(&_rg_state.sgci);
+}
+
+bool retrogauntlet_verify_snapshot_kernels() {
+    return core_verify_snapshot_kernels(core_get_cpu_features());
+}
+
+static int compare_uint64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+//Run a started gauntlet as fast as possible and report timings.
+bool benchmark_gauntlet(struct gauntlet *g, struct sdl_gl_core_interface *sgci, uint64_t *run_ticks, const size_t nr_frames) {
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    uint64_t total_run_ticks = 0;
+    uint64_t total_check_ticks = 0;
+    uint64_t max_check_ticks = 0;
+    size_t status_frame = 0;
+    const uint64_t start_ticks = SDL_GetPerformanceCounter();
+
+    fprintf(INFO_FILE, "Benchmarking '%s' for %zu frames...\n", g->title, nr_frames);
+
+    for (size_t i = 0; i < nr_frames; ++i) {
+        const uint64_t t0 = SDL_GetPerformanceCounter();
+
+        sdl_gl_if_run_frame(sgci);
+        gauntlet_count_frame(g, sgci->core.frames_per_second);
+
+        const uint64_t t1 = SDL_GetPerformanceCounter();
+        const enum gauntlet_status status = g->status;
+
+        gauntlet_check_status(g, sgci);
+
+        const uint64_t t2 = SDL_GetPerformanceCounter();
+
+        if (status == RETRO_GAUNTLET_RUNNING && g->status != RETRO_GAUNTLET_RUNNING) status_frame = i + 1;
+
+        run_ticks[i] = t1 - t0;
+        total_run_ticks += t1 - t0;
+        total_check_ticks += t2 - t1;
+        max_check_ticks = max(max_check_ticks, t2 - t1);
+    }
+
+    const double total_time = (double)(SDL_GetPerformanceCounter() - start_ticks)/frequency;
+
+    qsort(run_ticks, nr_frames, sizeof(uint64_t), compare_uint64);
+
+    fprintf(BENCH_FILE, "gauntlet: %s\n", g->title);
+    fprintf(BENCH_FILE, "frames: %zu\n", nr_frames);
+    fprintf(BENCH_FILE, "frames_per_second: %.2f\n", (double)nr_frames/total_time);
+    fprintf(BENCH_FILE, "core_frames_per_second: %.3f\n", sgci->core.frames_per_second);
+    fprintf(BENCH_FILE, "run_mean_us: %.3f\n", 1.0e6*(double)total_run_ticks/(frequency*(double)nr_frames));
+    fprintf(BENCH_FILE, "run_p99_us: %.3f\n", 1.0e6*(double)run_ticks[(99*(nr_frames - 1))/100]/frequency);
+    fprintf(BENCH_FILE, "run_max_us: %.3f\n", 1.0e6*(double)run_ticks[nr_frames - 1]/frequency);
+    if (sgci->nr_runahead_runs > 0) fprintf(BENCH_FILE, "runahead_mean_us: %.3f (%zu frames)\n", 1.0e6*(double)sgci->runahead_ticks/(frequency*(double)sgci->nr_runahead_runs), sgci->nr_runahead_frames);
+    fprintf(BENCH_FILE, "conditions: %zu win, %zu lose\n", g->nr_win_conditions, g->nr_lose_conditions);
+    fprintf(BENCH_FILE, "check_mean_us: %.3f\n", 1.0e6*(double)total_check_ticks/(frequency*(double)nr_frames));
+    fprintf(BENCH_FILE, "check_max_us: %.3f\n", 1.0e6*(double)max_check_ticks/frequency);
+    fprintf(BENCH_FILE, "status: %s at frame %zu\n", g->status == RETRO_GAUNTLET_WON ? "won" : (g->status == RETRO_GAUNTLET_LOST ? "lost" : "running"), status_frame);
+    if (g->status != RETRO_GAUNTLET_RUNNING) fprintf(BENCH_FILE, "finish_time_ms: %u (%u wall-clock)\n", gauntlet_get_time(g), gauntlet_get_wall_time(g));
+
+    return true;
+}
+
+//Run a gauntlet without window, OpenGL context, or audio device.
+bool retrogauntlet_benchmark(const char *data_directory, const char *ini_file, const size_t nr_frames) {
+    if (!data_directory || !ini_file || nr_frames == 0) {
+        fprintf(ERROR_FILE, "retrogauntlet_benchmark: Invalid data directory, INI file, or number of frames!\n");
+        return false;
+    }
+
+    if (_rg_state.window) {
+        fprintf(ERROR_FILE, "retrogauntlet_benchmark: Retrogauntlet instance is already running!\n");
+        return false;
+    }
+
+    struct gauntlet *g = &_rg_state.gauntlet;
+    char *full_ini_file = combine_paths(data_directory, ini_file);
+    uint64_t *run_ticks = (uint64_t *)calloc(nr_frames, sizeof(uint64_t));
+    bool result = false;
+
+    if (!full_ini_file || !run_ticks) {
+        fprintf(ERROR_FILE, "retrogauntlet_benchmark: Insufficient memory!\n");
+    }
+    else if (create_gauntlet(g, full_ini_file, data_directory)) {
+        if (setup_headless_app_for_gauntlet(g) && gauntlet_start(g, &_rg_state.sgci)) {
+            result = benchmark_gauntlet(g, &_rg_state.sgci, run_ticks, nr_frames);
+        }
+        else {
+            fprintf(ERROR_FILE, "retrogauntlet_benchmark: Unable to start gauntlet '%s'!\n", full_ini_file);
+        }
+
+        gauntlet_stop(g);
+        free_gauntlet(g);
+        free_sdl_gl_if(&_rg_state.sgci);
+    }
+
+    if (full_ini_file) free(full_ini_file);
+    if (run_ticks) free(run_ticks);
+    
+    return result;
+}
+
 //Set up global retrogauntlet instance.
 bool retrogauntlet_initialize(const char *data_directory, SDL_Window *window) {
     if (_rg_state.window) {
@@ -471,8 +635,8 @@ bool retrogauntlet_frame_update() {
     if ((_rg_state.menu.state == RETRO_GAUNTLET_STATE_SELECT_GAUNTLET ||
          _rg_state.menu.state == RETRO_GAUNTLET_STATE_LOBBY_HOST ||
          _rg_state.menu.state == RETRO_GAUNTLET_STATE_LOBBY_CLIENT) && _rg_state.gauntlet.ini_file) {
-        _rg_state.start_ticks = 0;
-        _rg_state.nr_frames = 0;
+        frame_pacer_restart(&_rg_state.pacer, true);
+        frame_pacer_restart(&_rg_state.emulation_pacer, true);
         menu_stop_mixer(&_rg_state.menu);
         
         //Set up global interface with SDL.
@@ -382,6 +382,8 @@ bool create_sdl_gl_if(struct sdl_gl_core_interface *sgci) {
     //Setup video.
     if (!create_video(&sgci->video)) return false;
 
+    sgci->video.stream_frames = true;
+
     return true;
 }
 
@@ -404,65 +406,148 @@ size_t audio_refresh(struct sdl_gl_core_interface *sgci, const int16_t *data, si
 
     if (!data || frames == 0 || sgci->audio_device_id == 0) return 0;
 
-    SDL_LockAudioDevice(sgci->audio_device_id);
+    //Resample to the device rate, adjusting the rate slightly to keep the ring half full.
+    const double fill = (double)audio_ring_available(&sgci->audio_ring)/(double)sgci->audio_ring.nr_bytes;
+    const size_t nr_output = audio_resampler_process(&sgci->audio_resampler, data, frames, fill);
+
+    //Samples that do not fit are dropped and counted as an overflow.
+    audio_ring_write(&sgci->audio_ring, sgci->audio_resampler.output, 2*sizeof(int16_t)*nr_output);
+
+    //Newly queued audio is heard after the ring and a full device buffer have been played.
+    sgci->audio_queued_latency = 1000.0*(double)(audio_ring_available(&sgci->audio_ring)/(2*sizeof(int16_t)) + sgci->audio_spec.samples)/(double)sgci->audio_spec.freq;
+    sgci->audio_queued_latency_sum += sgci->audio_queued_latency;
+    sgci->nr_audio_latency_samples++;
+
+    return frames;
+}
+
+void sdl_audio_cb(void *data, Uint8 *stream, int len) {
+    struct sdl_gl_core_interface *sgci = (struct sdl_gl_core_interface *)data;
+
+    audio_ring_read(&sgci->audio_ring, stream, (size_t)len);
+}
 
-    size_t nr_write = 2*sizeof(int16_t)*frames;
-    size_t first_write = nr_write;
-    size_t rest_write = 0;
-    size_t audio_buffer_end = (sgci->audio_buffer_start + sgci->audio_buffer_available) % sgci->nr_audio_buffer;
+bool sdl_gl_if_reset_audio(struct sdl_gl_core_interface *sgci) {
+    if (!sgci || !sgci->audio_ring.data || !sgci->sdl_scancode_override_key_map) {
+        fprintf(ERROR_FILE, "sdl_gl_if_reset_audio: Invalid interface or no audio buffer initialized!\n");
+        return false;
+    }
     
-    if (audio_buffer_end + nr_write > sgci->nr_audio_buffer) {
-        first_write = sgci->nr_audio_buffer - audio_buffer_end;
-        rest_write = nr_write - first_write;
+    //Keep the audio callback from reading while we discard queued samples.
+    if (sgci->audio_device_id) SDL_LockAudioDevice(sgci->audio_device_id);
+    audio_ring_clear(&sgci->audio_ring);
+    if (sgci->audio_device_id) SDL_UnlockAudioDevice(sgci->audio_device_id);
+    return true;
+}
+
+double sdl_gl_if_get_mean_audio_latency(const struct sdl_gl_core_interface *sgci) {
+    if (!sgci || sgci->nr_audio_latency_samples == 0) return 0.0;
+
+    return sgci->audio_queued_latency_sum/(double)sgci->nr_audio_latency_samples;
+}
+
+bool sdl_gl_if_start_runahead(struct sdl_gl_core_interface *sgci, const size_t nr_frames) {
+    if (!sgci) {
+        fprintf(ERROR_FILE, "sdl_gl_if_start_runahead: Invalid interface!\n");
+        return false;
     }
 
-    memcpy(sgci->audio_buffer + audio_buffer_end, (const uint8_t *)data, first_write);
-    memcpy(sgci->audio_buffer, (const uint8_t *)data + first_write, rest_write);
+    free_core_state_pool(&sgci->runahead_states);
+    sgci->nr_runahead_frames = 0;
+    sgci->runahead_ticks = 0;
+    sgci->nr_runahead_runs = 0;
+
+    if (nr_frames == 0) return true;
+
+    sgci->core_fast_states = true;
 
-    sgci->audio_buffer_available += nr_write;
+    const bool result = create_core_state_pool(&sgci->runahead_states, &sgci->core, 1);
 
-    //Catch up if needed.
-    if (sgci->audio_buffer_available > sgci->nr_audio_buffer) {
-        sgci->audio_buffer_start = (sgci->audio_buffer_start + sgci->audio_buffer_available - sgci->nr_audio_buffer) % sgci->nr_audio_buffer;
-        sgci->audio_buffer_available = sgci->nr_audio_buffer;
+    sgci->core_fast_states = false;
+
+    if (!result) {
+        fprintf(ERROR_FILE, "sdl_gl_if_start_runahead: Unable to save states, disabling run-ahead!\n");
+        return false;
     }
 
-    SDL_UnlockAudioDevice(sgci->audio_device_id);
+    sgci->nr_runahead_frames = nr_frames;
+    fprintf(INFO_FILE, "Running %zu frames ahead.\n", nr_frames);
 
-    return frames;
+    return true;
 }
 
-void sdl_audio_cb(void *data, Uint8 *stream, int len) {
-    struct sdl_gl_core_interface *sgci = (struct sdl_gl_core_interface *)data;
-    size_t nr_write = min((size_t)len, sgci->audio_buffer_available);
-    size_t first_write = nr_write;
-    size_t rest_write = 0;
+//Run a single frame, showing the state a few frames ahead to hide the core's input lag.
+bool sdl_gl_if_run_frame(struct sdl_gl_core_interface *sgci) {
+    if (!sgci) {
+        fprintf(ERROR_FILE, "sdl_gl_if_run_frame: Invalid interface!\n");
+        return false;
+    }
 
-    if (sgci->audio_buffer_start + nr_write > sgci->nr_audio_buffer) {
-        first_write = sgci->nr_audio_buffer - sgci->audio_buffer_start;
-        rest_write = nr_write - first_write;
+    if (sgci->nr_runahead_frames == 0) {
+        sgci->core.retro_run();
+        return true;
     }
-    
-    memcpy(stream, sgci->audio_buffer + sgci->audio_buffer_start, first_write);
-    memcpy((uint8_t *)stream + first_write, sgci->audio_buffer, rest_write);
-    memset((uint8_t *)stream + nr_write, 0, (size_t)len - nr_write);
 
-    sgci->audio_buffer_start = (sgci->audio_buffer_start + nr_write) % sgci->nr_audio_buffer;
-    sgci->audio_buffer_available -= nr_write;
-}
+    //Advance the actual state without showing it.
+    const bool skip_video = sgci->core_skip_video;
 
-bool sdl_gl_if_reset_audio(struct sdl_gl_core_interface *sgci) {
-    if (!sgci || !sgci->audio_buffer || !sgci->sdl_scancode_override_key_map) {
-        fprintf(ERROR_FILE, "sdl_gl_if_reset_audio: Invalid interface or no audio buffer initialized!\n");
+    sgci->core_skip_video = true;
+    sgci->core.retro_run();
+
+    const uint64_t start_ticks = SDL_GetPerformanceCounter();
+    size_t nr_bytes = 0;
+
+    sgci->core_fast_states = true;
+
+    const uint8_t *state = core_serialize_to_pool(&sgci->runahead_states, &sgci->core, &nr_bytes);
+
+    sgci->core_fast_states = false;
+
+    if (!state) {
+        fprintf(ERROR_FILE, "sdl_gl_if_run_frame: Unable to save state, disabling run-ahead!\n");
+        sgci->nr_runahead_frames = 0;
+        sgci->core_skip_video = skip_video;
         return false;
     }
-    
-    sgci->audio_buffer_start = 0;
-    sgci->audio_buffer_available = 0;
-    memset(sgci->audio_buffer, 0, sgci->nr_audio_buffer);
+
+    //Run ahead silently and only show the last frame.
+    sgci->core_skip_audio = true;
+
+    for (size_t i = 0; i < sgci->nr_runahead_frames; ++i) {
+        sgci->core_skip_video = (skip_video || i + 1 < sgci->nr_runahead_frames);
+        sgci->core.retro_run();
+    }
+
+    sgci->core_skip_audio = false;
+    sgci->core_skip_video = skip_video;
+
+    //Return to the actual state.
+    sgci->core_fast_states = true;
+
+    const bool result = sgci->core.retro_unserialize(state, nr_bytes);
+
+    sgci->core_fast_states = false;
+
+    if (!result) {
+        fprintf(ERROR_FILE, "sdl_gl_if_run_frame: Unable to restore state, disabling run-ahead!\n");
+        sgci->nr_runahead_frames = 0;
+        return false;
+    }
+
+    sgci->runahead_ticks += SDL_GetPerformanceCounter() - start_ticks;
+    sgci->nr_runahead_runs++;
+
     return true;
 }
 
+//Largest power of two number of samples per device buffer within the latency budget at the given frequency.
+static Uint16 sdl_gl_if_get_audio_samples(const int freq, const unsigned latency) {
+    //Rate control keeps two device buffers in the ring, while the device plays a third.
+    const uint32_t nr_samples = (uint32_t)(1.0e-3*(double)freq*(double)latency/3.0);
+
+    return (Uint16)min(max(next_pow2(nr_samples + 1) >> 1, 256u), 8192u);
+}
+
 bool sdl_gl_if_create_core_buffers(struct sdl_gl_core_interface *sgci) {
     if (!sgci || !sgci->core.retro_get_system_av_info) {
         fprintf(ERROR_FILE, "sdl_gl_if_create_buffers: Invalid interface or no core loaded!\n");
@@ -479,49 +564,90 @@ bool sdl_gl_if_create_core_buffers(struct sdl_gl_core_interface *sgci) {
     if (!video_set_geometry(&sgci->video, &core_av.geometry)) return false;
     if (!create_video_buffers(&sgci->video)) return false;
 
-    //Audio buffers.
+    //Audio buffers: rate control keeps the ring half full, so the ring and the device hold three device buffers.
     SDL_AudioSpec audio_spec = {0};
+    const unsigned latency = max(sgci->audio_latency_target, sgci->audio_latency);
 
     audio_spec.freq = (int)sgci->core.sample_rate;
     audio_spec.format = AUDIO_S16SYS;
     audio_spec.channels = 2;
-    audio_spec.samples = 2048; //next_pow2((uint32_t)(0.25e-3*sgci->core.sample_rate*(double)sgci->audio_latency));
+    audio_spec.samples = sdl_gl_if_get_audio_samples(audio_spec.freq, latency);
     audio_spec.callback = sdl_audio_cb;
     audio_spec.userdata = sgci;
     
-    sgci->audio_device_id = SDL_OpenAudioDevice(NULL, 0, &audio_spec, &sgci->audio_spec, 0);
+    //Let the device run at its native rate, we resample to it.
+    sgci->audio_device_id = SDL_OpenAudioDevice(NULL, 0, &audio_spec, &sgci->audio_spec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
     
+    //The buffer duration depends on the rate we obtained, so reopen the device if it runs slower than the core.
+    if (sgci->audio_device_id != 0 && sgci->audio_spec.samples > sdl_gl_if_get_audio_samples(sgci->audio_spec.freq, latency)) {
+        SDL_CloseAudioDevice(sgci->audio_device_id);
+        audio_spec.freq = sgci->audio_spec.freq;
+        audio_spec.samples = sdl_gl_if_get_audio_samples(audio_spec.freq, latency);
+        sgci->audio_device_id = SDL_OpenAudioDevice(NULL, 0, &audio_spec, &sgci->audio_spec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    }
+
     if (sgci->audio_device_id == 0) {
         fprintf(ERROR_FILE, "sdl_gl_if_create_buffers: Unable to open SDL audio device: %s!\n", SDL_GetError());
         return false;
     }
 
-    sgci->nr_audio_buffer = 2*sizeof(int16_t)*(size_t)sgci->audio_spec.channels*(size_t)sgci->audio_spec.samples;
-    sgci->audio_buffer_start = 0;
-    sgci->audio_buffer_available = 0;
-    sgci->audio_buffer = (uint8_t *)calloc(sgci->nr_audio_buffer, 1);
+    if (3000.0*(double)sgci->audio_spec.samples > (double)latency*(double)sgci->audio_spec.freq) {
+        fprintf(WARN_FILE, "sdl_gl_if_create_buffers: Audio buffer of %u samples at %d Hz exceeds the latency of %u ms!\n", sgci->audio_spec.samples, sgci->audio_spec.freq, latency);
+    }
 
-    if (!sgci->audio_buffer) {
-        fprintf(ERROR_FILE, "sdl_gl_if_create_buffers: Unable to allocate audio buffer of %zu samples!\n", sgci->nr_audio_buffer);
+    if (!create_audio_resampler(&sgci->audio_resampler, sgci->core.sample_rate, (double)sgci->audio_spec.freq, AUDIO_RESAMPLER_MAX_DEVIATION)) {
+        fprintf(ERROR_FILE, "sdl_gl_if_create_buffers: Unable to create audio resampler!\n");
+        return false;
+    }
+
+    //Leave room for rate control to keep the ring half full while the callback drains a device buffer at once.
+    if (!create_audio_ring(&sgci->audio_ring, 4*sizeof(int16_t)*(size_t)sgci->audio_spec.channels*(size_t)sgci->audio_spec.samples)) {
+        fprintf(ERROR_FILE, "sdl_gl_if_create_buffers: Unable to allocate audio buffer of %u samples!\n", sgci->audio_spec.samples);
         return false;
     }
 
     SDL_PauseAudioDevice(sgci->audio_device_id, 0);
 
-    fprintf(INFO_FILE, "Opened audio device with frequency %d, %d channels, and %u samples.\n", sgci->audio_spec.freq, sgci->audio_spec.channels, sgci->audio_spec.samples);
+    fprintf(INFO_FILE, "Opened audio device with frequency %d, %d channels, and %u samples for a latency of %u ms (core minimum %u ms).\n", sgci->audio_spec.freq, sgci->audio_spec.channels, sgci->audio_spec.samples, latency, sgci->audio_latency);
     
     return true;
 }
 
+bool sdl_gl_if_create_headless_core_buffers(struct sdl_gl_core_interface *sgci) {
+    if (!sgci || !sgci->core.retro_get_system_av_info) {
+        fprintf(ERROR_FILE, "sdl_gl_if_create_headless_core_buffers: Invalid interface or no core loaded!\n");
+        return false;
+    }
+    
+    struct retro_system_av_info core_av;
+    
+    memset(&core_av, 0, sizeof(struct retro_system_av_info));
+    sgci->core.retro_get_system_av_info(&core_av);
+    sgci->core.sample_rate = core_av.timing.sample_rate;
+    sgci->core.frames_per_second = core_av.timing.fps;
+
+    //Only keep track of the geometry, no OpenGL buffers are created.
+    if (!video_set_geometry(&sgci->video, &core_av.geometry)) return false;
+
+    //Audio buffer without an SDL audio device, such that audio_refresh() discards all samples.
+    sgci->audio_device_id = 0;
+    if (!create_audio_ring(&sgci->audio_ring, 2*sizeof(int16_t)*2*2048)) {
+        fprintf(ERROR_FILE, "sdl_gl_if_create_headless_core_buffers: Unable to allocate audio buffer of %u samples!\n", 2048u);
+        return false;
+    }
+
+    return true;
+}
+
 bool free_sdl_gl_if(struct sdl_gl_core_interface *sgci) {
     if (!sgci) {
         fprintf(ERROR_FILE, "free_sdl_gl_if: Invalid interface!\n");
         return false;
     }
     
+    free_core_state_pool(&sgci->runahead_states);
     free_core(&sgci->core);
     free_video(&sgci->video);
-    if (sgci->audio_buffer) free(sgci->audio_buffer);
     if (sgci->sdl_scancode_override_key_map) free(sgci->sdl_scancode_override_key_map);
     if (sgci->sdl_scancode_to_retro_key_map) free(sgci->sdl_scancode_to_retro_key_map);
     if (sgci->sdl_scancode_to_retro_pad_map) free(sgci->sdl_scancode_to_retro_pad_map);
@@ -532,6 +658,10 @@ bool free_sdl_gl_if(struct sdl_gl_core_interface *sgci) {
         SDL_PauseAudioDevice(sgci->audio_device_id, 1);
         SDL_CloseAudioDevice(sgci->audio_device_id);
     }
+    
+    //Only free the ring once the audio callback can no longer read it.
+    free_audio_ring(&sgci->audio_ring);
+    free_audio_resampler(&sgci->audio_resampler);
 
     memset(sgci, 0, sizeof(struct sdl_gl_core_interface));
 
@@ -0,0 +1,244 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "snapshotsimd.h"
+
+bool snapshot_data_condition(const unsigned data_condition, const uint64_t n, const uint64_t o, const uint64_t const_value) {
+    switch (data_condition) {
+        case MASK_IF_DATA_ALWAYS: return true;
+        case MASK_IF_DATA_CHANGED: return (n != o);
+        case MASK_IF_DATA_EQUAL_PREV: return (n == o);
+        case MASK_IF_DATA_GREATER_PREV: return (n > o);
+        case MASK_IF_DATA_LESS_PREV: return (n < o);
+        case MASK_IF_DATA_EQUAL_CONST: return (n == const_value);
+        case MASK_IF_DATA_GREATER_CONST: return (n > const_value);
+        case MASK_IF_DATA_LESS_CONST: return (n < const_value);
+    }
+
+    return false;
+}
+
+uint8_t snapshot_mask_action(const unsigned mask_action, const uint8_t m) {
+    switch (mask_action) {
+        case MASK_THEN_SET_ZERO: return 0;
+        case MASK_THEN_SET_ONE: return 1;
+        case MASK_THEN_OR_ONE: return m | 1;
+        case MASK_THEN_AND_ONE: return m & 1;
+        case MASK_THEN_XOR_ONE: return m ^ 1;
+        case MASK_THEN_ADD_ONE: return m + (m < 0xff ? 1 : 0);
+        case MASK_THEN_SUB_ONE: return m - (m > 0x00 ? 1 : 0);
+    }
+
+    return m;
+}
+
+//The kernels are compiled with per-function target attributes, such that no global -msse2/-mavx2 is required.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SNAPSHOT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef SNAPSHOT_SIMD_X86
+
+#define SIMD_INLINE static inline __attribute__((always_inline))
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+//Scalar version of the kernels for a single byte offset, used for the tail of each snapshot. Values are little-endian.
+static void snapshot_update_offset(uint8_t *m_p, const uint8_t *o_p, const uint8_t *n_p, const size_t i,
+                                   const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action,
+                                   const size_t nr_bytes, const uint64_t const_value) {
+    const uint8_t m = m_p[i];
+    uint64_t o = 0;
+    uint64_t n = 0;
+
+    if ((mask_condition == MASK_IF_MASK_ZERO && m != 0) ||
+        (mask_condition == MASK_IF_MASK_ONE && m != 1)) return;
+
+    if (data_condition != MASK_IF_DATA_ALWAYS) {
+        memcpy(&o, o_p + i, nr_bytes);
+        memcpy(&n, n_p + i, nr_bytes);
+    }
+
+    if (snapshot_data_condition(data_condition, n, o, const_value)) m_p[i] = snapshot_mask_action(mask_action, m);
+}
+
+//Byte-wise vector primitives with identical names per instruction set, such that SNAPSHOT_SIMD_LOOP can be shared.
+SIMD_INLINE SSE2_TARGET __m128i sse2_load(const uint8_t *p) {return _mm_loadu_si128((const __m128i *)p);}
+SIMD_INLINE SSE2_TARGET void sse2_store(uint8_t *p, const __m128i a) {_mm_storeu_si128((__m128i *)p, a);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_set1(const uint8_t a) {return _mm_set1_epi8((char)a);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_and(const __m128i a, const __m128i b) {return _mm_and_si128(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_or(const __m128i a, const __m128i b) {return _mm_or_si128(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_xor(const __m128i a, const __m128i b) {return _mm_xor_si128(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_andnot(const __m128i a, const __m128i b) {return _mm_andnot_si128(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_eq(const __m128i a, const __m128i b) {return _mm_cmpeq_epi8(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_gt(const __m128i a, const __m128i b) {return _mm_cmpgt_epi8(_mm_xor_si128(a, _mm_set1_epi8((char)0x80)), _mm_xor_si128(b, _mm_set1_epi8((char)0x80)));}
+SIMD_INLINE SSE2_TARGET __m128i sse2_adds(const __m128i a, const __m128i b) {return _mm_adds_epu8(a, b);}
+SIMD_INLINE SSE2_TARGET __m128i sse2_subs(const __m128i a, const __m128i b) {return _mm_subs_epu8(a, b);}
+
+SIMD_INLINE AVX2_TARGET __m256i avx2_load(const uint8_t *p) {return _mm256_loadu_si256((const __m256i *)p);}
+SIMD_INLINE AVX2_TARGET void avx2_store(uint8_t *p, const __m256i a) {_mm256_storeu_si256((__m256i *)p, a);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_set1(const uint8_t a) {return _mm256_set1_epi8((char)a);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_and(const __m256i a, const __m256i b) {return _mm256_and_si256(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_or(const __m256i a, const __m256i b) {return _mm256_or_si256(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_xor(const __m256i a, const __m256i b) {return _mm256_xor_si256(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_andnot(const __m256i a, const __m256i b) {return _mm256_andnot_si256(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_eq(const __m256i a, const __m256i b) {return _mm256_cmpeq_epi8(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_gt(const __m256i a, const __m256i b) {return _mm256_cmpgt_epi8(_mm256_xor_si256(a, _mm256_set1_epi8((char)0x80)), _mm256_xor_si256(b, _mm256_set1_epi8((char)0x80)));}
+SIMD_INLINE AVX2_TARGET __m256i avx2_adds(const __m256i a, const __m256i b) {return _mm256_adds_epu8(a, b);}
+SIMD_INLINE AVX2_TARGET __m256i avx2_subs(const __m256i a, const __m256i b) {return _mm256_subs_epu8(a, b);}
+
+//Process nr_lanes byte offsets at once. Multi-byte values at consecutive offsets overlap, so a value of nr_bytes bytes is compared with nr_bytes shifted loads, from least to most significant byte.
+//nr_bytes and data_condition are compile-time constants at every call site, such that each combination gets its own specialized loop.
+#define SNAPSHOT_SIMD_LOOP(isa, target, vec, nr_lanes) \
+SIMD_INLINE target size_t isa##_update_mask(uint8_t *m_p, const uint8_t *o_p, const uint8_t *n_p, const size_t nr_offsets, \
+                                            const unsigned mask_condition, const unsigned data_condition, const unsigned mask_action, \
+                                            const size_t nr_bytes, const uint64_t const_value) { \
+    const vec zero = isa##_set1(0x00); \
+    const vec one = isa##_set1(0x01); \
+    const vec ones = isa##_set1(0xff); \
+    const bool with_const = (data_condition == MASK_IF_DATA_EQUAL_CONST || data_condition == MASK_IF_DATA_GREATER_CONST || data_condition == MASK_IF_DATA_LESS_CONST); \
+    const bool with_gt = (data_condition == MASK_IF_DATA_GREATER_PREV || data_condition == MASK_IF_DATA_GREATER_CONST); \
+    const bool with_lt = (data_condition == MASK_IF_DATA_LESS_PREV || data_condition == MASK_IF_DATA_LESS_CONST); \
+    vec c_v[8]; \
+    size_t i = 0; \
+    \
+    for (size_t j = 0; j < nr_bytes; ++j) c_v[j] = isa##_set1((uint8_t)(const_value >> (8*j))); \
+    \
+    for (i = 0; i + nr_lanes <= nr_offsets; i += nr_lanes) { \
+        const vec m = isa##_load(m_p + i); \
+        vec eq = ones; \
+        vec gt = zero; \
+        vec lt = zero; \
+        vec c = ones; \
+        vec a = m; \
+        \
+        if (data_condition != MASK_IF_DATA_ALWAYS) { \
+            for (size_t j = 0; j < nr_bytes; ++j) { \
+                const vec n = isa##_load(n_p + i + j); \
+                const vec o = (with_const ? c_v[j] : isa##_load(o_p + i + j)); \
+                const vec e = isa##_eq(n, o); \
+                \
+                if (with_gt) gt = isa##_or(isa##_gt(n, o), isa##_and(e, gt)); \
+                if (with_lt) lt = isa##_or(isa##_gt(o, n), isa##_and(e, lt)); \
+                eq = isa##_and(eq, e); \
+            } \
+        } \
+        \
+        switch (mask_condition) { \
+            case MASK_IF_MASK_ZERO: c = isa##_eq(m, zero); break; \
+            case MASK_IF_MASK_ONE: c = isa##_eq(m, one); break; \
+        } \
+        \
+        switch (data_condition) { \
+            case MASK_IF_DATA_CHANGED: c = isa##_andnot(eq, c); break; \
+            case MASK_IF_DATA_EQUAL_PREV: case MASK_IF_DATA_EQUAL_CONST: c = isa##_and(eq, c); break; \
+            case MASK_IF_DATA_GREATER_PREV: case MASK_IF_DATA_GREATER_CONST: c = isa##_and(gt, c); break; \
+            case MASK_IF_DATA_LESS_PREV: case MASK_IF_DATA_LESS_CONST: c = isa##_and(lt, c); break; \
+        } \
+        \
+        switch (mask_action) { \
+            case MASK_THEN_SET_ZERO: a = zero; break; \
+            case MASK_THEN_SET_ONE: a = one; break; \
+            case MASK_THEN_OR_ONE: a = isa##_or(m, one); break; \
+            case MASK_THEN_AND_ONE: a = isa##_and(m, one); break; \
+            case MASK_THEN_XOR_ONE: a = isa##_xor(m, one); break; \
+            case MASK_THEN_ADD_ONE: a = isa##_adds(m, one); break; \
+            case MASK_THEN_SUB_ONE: a = isa##_subs(m, one); break; \
+        } \
+        \
+        isa##_store(m_p + i, isa##_or(isa##_and(c, a), isa##_andnot(c, m))); \
+    } \
+    \
+    return i; \
+}
+
+#define SNAPSHOT_SIMD_DATA_CONDITION(isa, nr_bytes) do { \
+    switch (data_condition) { \
+        case MASK_IF_DATA_ALWAYS: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_ALWAYS, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_CHANGED: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_CHANGED, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_EQUAL_PREV: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_EQUAL_PREV, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_GREATER_PREV: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_GREATER_PREV, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_LESS_PREV: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_LESS_PREV, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_EQUAL_CONST: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_EQUAL_CONST, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_GREATER_CONST: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_GREATER_CONST, mask_action, nr_bytes, const_value); break; \
+        case MASK_IF_DATA_LESS_CONST: i = isa##_update_mask(m_p, o_p, n_p, nr_offsets, mask_condition, MASK_IF_DATA_LESS_CONST, mask_action, nr_bytes, const_value); break; \
+        default: return; \
+    } \
+} while (false);
+
+#define SNAPSHOT_SIMD_KERNEL(isa, target) \
+static target void snapshot_##isa##_kernel(uint8_t *m_p, const uint8_t *o_p, const uint8_t *n_p, const size_t nr_offsets, \
+                                           const unsigned mask_condition, const unsigned input_data_condition, const unsigned mask_action, \
+                                           const unsigned size_value, const uint64_t const_value) { \
+    unsigned data_condition = input_data_condition; \
+    size_t nr_bytes = 0; \
+    size_t i = 0; \
+    \
+    switch (size_value) { \
+        case MEMCON_VAR_8BIT: nr_bytes = 1; break; \
+        case MEMCON_VAR_16BIT: nr_bytes = 2; break; \
+        case MEMCON_VAR_32BIT: nr_bytes = 4; break; \
+        case MEMCON_VAR_64BIT: nr_bytes = 8; break; \
+        default: return; \
+    } \
+    \
+    if (mask_condition == MASK_IF_MASK_NEVER || mask_action == MASK_THEN_NOP || mask_action == MASK_THEN_LOG) return; \
+    \
+    /* Constants that do not fit the value size can never be reached, or are always greater. */ \
+    if (nr_bytes < 8 && (const_value >> (8*nr_bytes)) != 0) { \
+        if (data_condition == MASK_IF_DATA_EQUAL_CONST || data_condition == MASK_IF_DATA_GREATER_CONST) return; \
+        if (data_condition == MASK_IF_DATA_LESS_CONST) data_condition = MASK_IF_DATA_ALWAYS; \
+    } \
+    \
+    switch (nr_bytes) { \
+        case 1: SNAPSHOT_SIMD_DATA_CONDITION(isa, 1); break; \
+        case 2: SNAPSHOT_SIMD_DATA_CONDITION(isa, 2); break; \
+        case 4: SNAPSHOT_SIMD_DATA_CONDITION(isa, 4); break; \
+        case 8: SNAPSHOT_SIMD_DATA_CONDITION(isa, 8); break; \
+    } \
+    \
+    for (; i < nr_offsets; ++i) { \
+        snapshot_update_offset(m_p, o_p, n_p, i, mask_condition, data_condition, mask_action, nr_bytes, const_value); \
+    } \
+}
+
+SNAPSHOT_SIMD_LOOP(sse2, SSE2_TARGET, __m128i, 16)
+SNAPSHOT_SIMD_LOOP(avx2, AVX2_TARGET, __m256i, 32)
+SNAPSHOT_SIMD_KERNEL(sse2, SSE2_TARGET)
+SNAPSHOT_SIMD_KERNEL(avx2, AVX2_TARGET)
+
+#endif
+
+//Select the widest kernel supported by the RETRO_SIMD_* flags from core_get_cpu_features(), or NULL for the scalar path.
+snapshot_kernel_t snapshot_simd_kernel(const uint64_t cpu_features) {
+#ifdef SNAPSHOT_SIMD_X86
+    if (cpu_features & RETRO_SIMD_AVX2) return snapshot_avx2_kernel;
+    if (cpu_features & RETRO_SIMD_SSE2) return snapshot_sse2_kernel;
+#else
+    (void)cpu_features;
+#endif
+    return NULL;
+}
+
+const char *snapshot_simd_kernel_name(const uint64_t cpu_features) {
+#ifdef SNAPSHOT_SIMD_X86
+    if (cpu_features & RETRO_SIMD_AVX2) return "avx2";
+    if (cpu_features & RETRO_SIMD_SSE2) return "sse2";
+#else
+    (void)cpu_features;
+#endif
+    return "scalar";
+}
+
@@ -0,0 +1,567 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+//Synthetic libretro core producing configurable video, audio, and memory traffic for reproducible benchmarks without game data.
+//The optional 'ROM' is a script with lines 'frame snapshot offset type value' (frame decimal, others hexadecimal as in condition files) writing values into memory at given frames.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "libretro.h"
+
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#if defined(__GNUC__)
+#define UNUSED(x)       x##_UNUSED __attribute__((unused))
+#else
+#define UNUSED(x)       x##_UNUSED
+#endif
+
+#define SYNTH_PI 3.14159265358979323846
+#define SYNTH_MAX_MMAP_REGIONS 16
+#define SYNTH_SERIALIZE_MAGIC 0x53594e54
+#define SYNTH_RESERVED_RAM 256
+
+struct synth_write {
+    uint64_t frame;
+    size_t snapshot;
+    size_t offset;
+    unsigned type;
+    uint64_t value;
+};
+
+struct synth_state {
+    //Settings.
+    unsigned width, height;
+    enum retro_pixel_format pixel_format;
+    unsigned bytes_per_pixel;
+    double fps;
+    double sample_rate;
+    unsigned dirty_rows_percent;
+    unsigned ram_writes;
+
+    //Memory regions, indexed as the snapshots in core.c.
+    uint8_t *save_ram;
+    size_t nr_save_ram;
+    uint8_t *system_ram;
+    size_t nr_system_ram;
+    uint8_t *mmap_ram[SYNTH_MAX_MMAP_REGIONS];
+    size_t nr_mmap_ram;
+    unsigned nr_mmap_regions;
+
+    //Output buffers.
+    uint8_t *frame_buffer;
+    int16_t *audio_buffer;
+    size_t nr_audio_buffer;
+
+    //Scripted writes, sorted by frame.
+    struct synth_write *writes;
+    size_t nr_writes;
+    size_t i_write;
+
+    //Running state, serialized.
+    uint64_t frame;
+    uint64_t rng;
+    double audio_phase;
+    double audio_frames;
+};
+
+static struct synth_state synth = {0};
+
+static retro_environment_t environ_cb = NULL;
+static retro_video_refresh_t video_cb = NULL;
+static retro_audio_sample_t audio_cb = NULL;
+static retro_audio_sample_batch_t audio_batch_cb = NULL;
+static retro_input_poll_t input_poll_cb = NULL;
+static retro_input_state_t input_state_cb = NULL;
+static retro_log_printf_t log_cb = NULL;
+
+static const struct retro_variable synth_variables[] = {
+    {"synth_width", "Framebuffer width; 320|640|800|1024|1280|1920"},
+    {"synth_height", "Framebuffer height; 200|400|480|600|768|1080"},
+    {"synth_pixel_format", "Pixel format; xrgb8888|rgb565|0rgb1555"},
+    {"synth_fps", "Frames per second; 60|70|50"},
+    {"synth_sample_rate", "Audio sample rate; 44100|48000|32000|22050"},
+    {"synth_dirty_rows", "Percentage of framebuffer rows changed per frame; 10|0|1|50|100"},
+    {"synth_system_ram_kb", "System RAM in kB; 1024|64|16384|65536"},
+    {"synth_save_ram_kb", "Save RAM in kB; 8|0|64"},
+    {"synth_mmap_regions", "Number of additional memory map regions; 0|1|2|4|8|16"},
+    {"synth_mmap_kb", "Size of each memory map region in kB; 1024|64|16384"},
+    {"synth_ram_writes", "Number of pseudo-random memory writes per frame; 64|0|1024|65536"},
+    {NULL, NULL}
+};
+
+static void synth_log(enum retro_log_level level, const char *format, const char *text) {
+    if (log_cb) log_cb(level, format, text);
+    else fprintf(stderr, format, text);
+}
+
+static unsigned get_variable_uint(const char *key, const unsigned default_value) {
+    struct retro_variable var = {key, NULL};
+
+    if (!environ_cb || !environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) || !var.value) return default_value;
+
+    return (unsigned)strtoul(var.value, NULL, 10);
+}
+
+static const char *get_variable_string(const char *key, const char *default_value) {
+    struct retro_variable var = {key, NULL};
+
+    if (!environ_cb || !environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) || !var.value) return default_value;
+
+    return var.value;
+}
+
+//xorshift64 generator, deterministic and part of the serialized state.
+static uint64_t synth_rand(void) {
+    synth.rng ^= synth.rng << 13;
+    synth.rng ^= synth.rng >> 7;
+    synth.rng ^= synth.rng << 17;
+    return synth.rng;
+}
+
+static uint8_t *synth_get_region(const size_t snapshot, size_t *nr_data) {
+    *nr_data = 0;
+
+    switch (snapshot) {
+        case RETRO_MEMORY_SAVE_RAM:
+            *nr_data = synth.nr_save_ram;
+            return synth.save_ram;
+        case RETRO_MEMORY_SYSTEM_RAM:
+            *nr_data = synth.nr_system_ram;
+            return synth.system_ram;
+        default:
+            if (snapshot >= 4 && snapshot < 4 + synth.nr_mmap_regions) {
+                *nr_data = synth.nr_mmap_ram;
+                return synth.mmap_ram[snapshot - 4];
+            }
+    }
+
+    return NULL;
+}
+
+static void synth_write_value(const size_t snapshot, const size_t offset, const unsigned type, const uint64_t value) {
+    size_t nr_data = 0;
+    uint8_t *data = synth_get_region(snapshot, &nr_data);
+    const size_t size = (size_t)1 << (type & 3);
+
+    if (!data || offset + size > nr_data) return;
+
+    //Little endian as the memory of the cores we typically run.
+    for (size_t i = 0; i < size; ++i) data[offset + i] = (uint8_t)(value >> (8*i));
+}
+
+static int compare_writes(const void *a, const void *b) {
+    const struct synth_write *x = (const struct synth_write *)a;
+    const struct synth_write *y = (const struct synth_write *)b;
+
+    return (x->frame > y->frame) - (x->frame < y->frame);
+}
+
+static bool synth_read_script(const void *data, const size_t nr_data) {
+    char *text = (char *)calloc(nr_data + 1, 1);
+
+    if (!text) return false;
+
+    memcpy(text, data, nr_data);
+
+    for (char *line = strtok(text, "\r\n"); line; line = strtok(NULL, "\r\n")) {
+        struct synth_write w;
+        unsigned long long frame, snapshot, offset, value;
+
+        if (line[0] == '#' || line[0] == ';' || line[0] == '/') continue;
+        if (sscanf(line, "%llu %llx %llx %x %llx", &frame, &snapshot, &offset, &w.type, &value) != 5) continue;
+
+        w.frame = frame;
+        w.snapshot = (size_t)snapshot;
+        w.offset = (size_t)offset;
+        w.value = value;
+
+        struct synth_write *writes = (struct synth_write *)realloc(synth.writes, (synth.nr_writes + 1)*sizeof(struct synth_write));
+
+        if (!writes) {
+            free(text);
+            return false;
+        }
+
+        synth.writes = writes;
+        synth.writes[synth.nr_writes++] = w;
+    }
+
+    free(text);
+
+    if (synth.nr_writes > 0) qsort(synth.writes, synth.nr_writes, sizeof(struct synth_write), compare_writes);
+
+    return true;
+}
+
+static void synth_free(void) {
+    if (synth.save_ram) free(synth.save_ram);
+    if (synth.system_ram) free(synth.system_ram);
+    for (unsigned i = 0; i < SYNTH_MAX_MMAP_REGIONS; ++i) {
+        if (synth.mmap_ram[i]) free(synth.mmap_ram[i]);
+    }
+    if (synth.frame_buffer) free(synth.frame_buffer);
+    if (synth.audio_buffer) free(synth.audio_buffer);
+    if (synth.writes) free(synth.writes);
+
+    memset(&synth, 0, sizeof(struct synth_state));
+}
+
+RETRO_API void retro_set_environment(retro_environment_t cb) {
+    environ_cb = cb;
+
+    bool no_game = true;
+    struct retro_log_callback logging;
+
+    cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &no_game);
+    cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void *)synth_variables);
+
+    if (cb(RETRO_ENVIRONMENT_GET_LOG_INTERFACE, &logging)) log_cb = logging.log;
+}
+
+RETRO_API void retro_set_video_refresh(retro_video_refresh_t cb) {
+    video_cb = cb;
+}
+
+RETRO_API void retro_set_audio_sample(retro_audio_sample_t cb) {
+    audio_cb = cb;
+}
+
+RETRO_API void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) {
+    audio_batch_cb = cb;
+}
+
+RETRO_API void retro_set_input_poll(retro_input_poll_t cb) {
+    input_poll_cb = cb;
+}
+
+RETRO_API void retro_set_input_state(retro_input_state_t cb) {
+    input_state_cb = cb;
+}
+
+RETRO_API void retro_init(void) {
+    synth_free();
+}
+
+RETRO_API void retro_deinit(void) {
+    synth_free();
+}
+
+RETRO_API unsigned retro_api_version(void) {
+    return RETRO_API_VERSION;
+}
+
+RETRO_API void retro_get_system_info(struct retro_system_info *info) {
+    memset(info, 0, sizeof(struct retro_system_info));
+    info->library_name = "Retro Gauntlet synthetic core";
+    info->library_version = "0.1";
+    info->valid_extensions = "txt";
+    info->need_fullpath = false;
+    info->block_extract = false;
+}
+
+RETRO_API void retro_get_system_av_info(struct retro_system_av_info *info) {
+    memset(info, 0, sizeof(struct retro_system_av_info));
+    info->geometry.base_width = synth.width;
+    info->geometry.base_height = synth.height;
+    info->geometry.max_width = synth.width;
+    info->geometry.max_height = synth.height;
+    info->geometry.aspect_ratio = 0.0f;
+    info->timing.fps = synth.fps;
+    info->timing.sample_rate = synth.sample_rate;
+}
+
+RETRO_API void retro_set_controller_port_device(unsigned UNUSED(port), unsigned UNUSED(device)) {
+}
+
+RETRO_API void retro_reset(void) {
+    synth.frame = 0;
+    synth.rng = 0x9e3779b97f4a7c15ULL;
+    synth.audio_phase = 0.0;
+    synth.audio_frames = 0.0;
+    synth.i_write = 0;
+
+    if (synth.save_ram) memset(synth.save_ram, 0, synth.nr_save_ram);
+    if (synth.system_ram) memset(synth.system_ram, 0, synth.nr_system_ram);
+    for (unsigned i = 0; i < synth.nr_mmap_regions; ++i) memset(synth.mmap_ram[i], 0, synth.nr_mmap_ram);
+}
+
+RETRO_API bool retro_load_game(const struct retro_game_info *game) {
+    //Read settings.
+    synth.width = max(1u, get_variable_uint("synth_width", 320));
+    synth.height = max(1u, get_variable_uint("synth_height", 200));
+    synth.fps = (double)max(1u, get_variable_uint("synth_fps", 60));
+    synth.sample_rate = (double)max(1000u, get_variable_uint("synth_sample_rate", 44100));
+    synth.dirty_rows_percent = min(100u, get_variable_uint("synth_dirty_rows", 10));
+    synth.nr_system_ram = 1024*(size_t)get_variable_uint("synth_system_ram_kb", 1024);
+    synth.nr_save_ram = 1024*(size_t)get_variable_uint("synth_save_ram_kb", 8);
+    synth.nr_mmap_regions = min(SYNTH_MAX_MMAP_REGIONS, get_variable_uint("synth_mmap_regions", 0));
+    synth.nr_mmap_ram = 1024*(size_t)get_variable_uint("synth_mmap_kb", 1024);
+    synth.ram_writes = get_variable_uint("synth_ram_writes", 64);
+
+    const char *format = get_variable_string("synth_pixel_format", "xrgb8888");
+
+    if (strcmp(format, "rgb565") == 0) {
+        synth.pixel_format = RETRO_PIXEL_FORMAT_RGB565;
+        synth.bytes_per_pixel = 2;
+    }
+    else if (strcmp(format, "0rgb1555") == 0) {
+        synth.pixel_format = RETRO_PIXEL_FORMAT_0RGB1555;
+        synth.bytes_per_pixel = 2;
+    }
+    else {
+        synth.pixel_format = RETRO_PIXEL_FORMAT_XRGB8888;
+        synth.bytes_per_pixel = 4;
+    }
+
+    if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &synth.pixel_format)) {
+        synth_log(RETRO_LOG_ERROR, "%s", "synthcore: Pixel format is not supported!\n");
+        return false;
+    }
+
+    //Allocate memory.
+    synth.frame_buffer = (uint8_t *)calloc((size_t)synth.width*synth.height, synth.bytes_per_pixel);
+    synth.nr_audio_buffer = 2*((size_t)ceil(synth.sample_rate/synth.fps) + 1);
+    synth.audio_buffer = (int16_t *)calloc(synth.nr_audio_buffer, sizeof(int16_t));
+    if (synth.nr_save_ram > 0) synth.save_ram = (uint8_t *)calloc(synth.nr_save_ram, 1);
+    if (synth.nr_system_ram > 0) synth.system_ram = (uint8_t *)calloc(synth.nr_system_ram, 1);
+
+    if (!synth.frame_buffer || !synth.audio_buffer ||
+        (synth.nr_save_ram > 0 && !synth.save_ram) ||
+        (synth.nr_system_ram > 0 && !synth.system_ram)) {
+        synth_log(RETRO_LOG_ERROR, "%s", "synthcore: Unable to allocate memory!\n");
+        return false;
+    }
+
+    //Expose additional memory map regions.
+    if (synth.nr_mmap_regions > 0 && synth.nr_mmap_ram > 0) {
+        struct retro_memory_descriptor descriptors[SYNTH_MAX_MMAP_REGIONS];
+        struct retro_memory_map mmap = {descriptors, synth.nr_mmap_regions};
+
+        memset(descriptors, 0, sizeof(descriptors));
+
+        for (unsigned i = 0; i < synth.nr_mmap_regions; ++i) {
+            if (!(synth.mmap_ram[i] = (uint8_t *)calloc(synth.nr_mmap_ram, 1))) {
+                synth_log(RETRO_LOG_ERROR, "%s", "synthcore: Unable to allocate memory map region!\n");
+                return false;
+            }
+
+            descriptors[i].flags = RETRO_MEMDESC_SYSTEM_RAM;
+            descriptors[i].ptr = synth.mmap_ram[i];
+            descriptors[i].start = (size_t)i*synth.nr_mmap_ram;
+            descriptors[i].len = synth.nr_mmap_ram;
+            descriptors[i].addrspace = "synth";
+        }
+
+        environ_cb(RETRO_ENVIRONMENT_SET_MEMORY_MAPS, &mmap);
+    }
+    else {
+        synth.nr_mmap_regions = 0;
+    }
+
+    if (game && game->data && game->size > 0) {
+        if (!synth_read_script(game->data, game->size)) {
+            synth_log(RETRO_LOG_ERROR, "%s", "synthcore: Unable to read script!\n");
+            return false;
+        }
+    }
+
+    retro_reset();
+
+    return true;
+}
+
+RETRO_API bool retro_load_game_special(unsigned UNUSED(type), const struct retro_game_info *UNUSED(info), size_t UNUSED(num)) {
+    return false;
+}
+
+RETRO_API void retro_unload_game(void) {
+}
+
+RETRO_API unsigned retro_get_region(void) {
+    return RETRO_REGION_NTSC;
+}
+
+static void synth_render(void) {
+    const size_t pitch = (size_t)synth.width*synth.bytes_per_pixel;
+    const unsigned nr_rows = (unsigned)(((uint64_t)synth.height*synth.dirty_rows_percent)/100);
+    const unsigned first_row = (unsigned)((synth.frame*(uint64_t)max(1u, nr_rows)) % synth.height);
+
+    //Change a band of rows, moving down every frame.
+    for (unsigned r = 0; r < nr_rows; ++r) {
+        const unsigned y = (first_row + r) % synth.height;
+        uint8_t *row = synth.frame_buffer + y*pitch;
+
+        for (unsigned x = 0; x < synth.width; ++x) {
+            const uint32_t c = (uint32_t)(x + y + synth.frame);
+
+            if (synth.bytes_per_pixel == 4) {
+                ((uint32_t *)row)[x] = ((c & 0xff) << 16) | (((c >> 1) & 0xff) << 8) | ((c >> 2) & 0xff);
+            }
+            else {
+                ((uint16_t *)row)[x] = (uint16_t)(c*0x0821);
+            }
+        }
+    }
+
+    if (video_cb) {
+        //Report frame duplicates when nothing changed.
+        if (nr_rows == 0) video_cb(NULL, synth.width, synth.height, pitch);
+        else video_cb(synth.frame_buffer, synth.width, synth.height, pitch);
+    }
+}
+
+static void synth_audio(void) {
+    //Keep the number of audio frames exactly consistent with the sample rate over time.
+    synth.audio_frames += synth.sample_rate/synth.fps;
+
+    const size_t nr_frames = min((size_t)synth.audio_frames, synth.nr_audio_buffer/2);
+    const double dphase = 2.0*SYNTH_PI*440.0/synth.sample_rate;
+
+    synth.audio_frames -= (double)nr_frames;
+
+    for (size_t i = 0; i < nr_frames; ++i) {
+        const int16_t s = (int16_t)(8192.0*sin(synth.audio_phase));
+
+        synth.audio_buffer[2*i + 0] = s;
+        synth.audio_buffer[2*i + 1] = (int16_t)(-s);
+        synth.audio_phase += dphase;
+    }
+
+    synth.audio_phase = fmod(synth.audio_phase, 2.0*SYNTH_PI);
+
+    if (audio_batch_cb) {
+        audio_batch_cb(synth.audio_buffer, nr_frames);
+    }
+    else if (audio_cb) {
+        for (size_t i = 0; i < nr_frames; ++i) audio_cb(synth.audio_buffer[2*i + 0], synth.audio_buffer[2*i + 1]);
+    }
+}
+
+RETRO_API void retro_run(void) {
+    uint16_t buttons = 0;
+
+    if (input_poll_cb) input_poll_cb();
+
+    if (input_state_cb) {
+        for (unsigned i = 0; i < 16; ++i) {
+            if (input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, i)) buttons |= (uint16_t)(1 << i);
+        }
+    }
+
+    //Pseudo-random memory traffic over all regions.
+    for (unsigned i = 0; i < synth.ram_writes; ++i) {
+        const uint64_t r = synth_rand();
+        const size_t region = (size_t)(r % (2 + synth.nr_mmap_regions));
+        size_t nr_data = 0;
+        uint8_t *data = synth_get_region(region == 0 ? RETRO_MEMORY_SYSTEM_RAM : (region == 1 ? RETRO_MEMORY_SAVE_RAM : 4 + region - 2), &nr_data);
+
+        //Leave the first bytes of each region for the frame counter, input, and scripted writes.
+        if (data && nr_data > SYNTH_RESERVED_RAM) data[SYNTH_RESERVED_RAM + (r >> 16) % (nr_data - SYNTH_RESERVED_RAM)] = (uint8_t)(r >> 8);
+    }
+
+    //Frame counter and input state at fixed locations.
+    synth_write_value(RETRO_MEMORY_SYSTEM_RAM, 0, 2, synth.frame);
+    synth_write_value(RETRO_MEMORY_SYSTEM_RAM, 4, 1, buttons);
+
+    //Scripted writes for this frame.
+    while (synth.i_write < synth.nr_writes && synth.writes[synth.i_write].frame <= synth.frame) {
+        const struct synth_write *w = &synth.writes[synth.i_write++];
+
+        synth_write_value(w->snapshot, w->offset, w->type, w->value);
+    }
+
+    synth_render();
+    synth_audio();
+
+    synth.frame++;
+}
+
+RETRO_API size_t retro_serialize_size(void) {
+    return 4*sizeof(uint64_t) + 2*sizeof(double) + synth.nr_save_ram + synth.nr_system_ram + synth.nr_mmap_regions*synth.nr_mmap_ram;
+}
+
+#define SERIALIZE_WRITE(src, size) do { memcpy(p, src, size); p += size; } while (false)
+#define SERIALIZE_READ(dest, size) do { memcpy(dest, p, size); p += size; } while (false)
+
+RETRO_API bool retro_serialize(void *data, size_t size) {
+    if (!data || size < retro_serialize_size()) return false;
+
+    uint8_t *p = (uint8_t *)data;
+    const uint64_t header[2] = {SYNTH_SERIALIZE_MAGIC, retro_serialize_size()};
+
+    SERIALIZE_WRITE(header, sizeof(header));
+    SERIALIZE_WRITE(&synth.frame, sizeof(uint64_t));
+    SERIALIZE_WRITE(&synth.rng, sizeof(uint64_t));
+    SERIALIZE_WRITE(&synth.audio_phase, sizeof(double));
+    SERIALIZE_WRITE(&synth.audio_frames, sizeof(double));
+    if (synth.save_ram) SERIALIZE_WRITE(synth.save_ram, synth.nr_save_ram);
+    if (synth.system_ram) SERIALIZE_WRITE(synth.system_ram, synth.nr_system_ram);
+    for (unsigned i = 0; i < synth.nr_mmap_regions; ++i) SERIALIZE_WRITE(synth.mmap_ram[i], synth.nr_mmap_ram);
+
+    return true;
+}
+
+RETRO_API bool retro_unserialize(const void *data, size_t size) {
+    if (!data || size < retro_serialize_size()) return false;
+
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t header[2];
+
+    SERIALIZE_READ(header, sizeof(header));
+
+    if (header[0] != SYNTH_SERIALIZE_MAGIC || header[1] != retro_serialize_size()) {
+        synth_log(RETRO_LOG_ERROR, "%s", "synthcore: Incompatible serialized state!\n");
+        return false;
+    }
+
+    SERIALIZE_READ(&synth.frame, sizeof(uint64_t));
+    SERIALIZE_READ(&synth.rng, sizeof(uint64_t));
+    SERIALIZE_READ(&synth.audio_phase, sizeof(double));
+    SERIALIZE_READ(&synth.audio_frames, sizeof(double));
+    if (synth.save_ram) SERIALIZE_READ(synth.save_ram, synth.nr_save_ram);
+    if (synth.system_ram) SERIALIZE_READ(synth.system_ram, synth.nr_system_ram);
+    for (unsigned i = 0; i < synth.nr_mmap_regions; ++i) SERIALIZE_READ(synth.mmap_ram[i], synth.nr_mmap_ram);
+
+    //Scripted writes resume from the restored frame.
+    synth.i_write = 0;
+    while (synth.i_write < synth.nr_writes && synth.writes[synth.i_write].frame < synth.frame) synth.i_write++;
+
+    return true;
+}
+
+RETRO_API void retro_cheat_reset(void) {
+}
+
+RETRO_API void retro_cheat_set(unsigned UNUSED(index), bool UNUSED(enabled), const char *UNUSED(code)) {
+}
+
+RETRO_API void *retro_get_memory_data(unsigned id) {
+    size_t nr_data = 0;
+
+    return synth_get_region(id, &nr_data);
+}
+
+RETRO_API size_t retro_get_memory_size(unsigned id) {
+    size_t nr_data = 0;
+
+    synth_get_region(id, &nr_data);
+
+    return nr_data;
+}
@@ -0,0 +1,117 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "retrogauntlet.h"
+#include "triplebuffer.h"
+
+bool create_video_triple_buffer(struct video_triple_buffer *buffer, const size_t nr_frame_bytes) {
+    if (!buffer || nr_frame_bytes == 0) {
+        fprintf(ERROR_FILE, "create_video_triple_buffer: Invalid buffer or size!\n");
+        return false;
+    }
+
+    memset(buffer, 0, sizeof(struct video_triple_buffer));
+    buffer->nr_frame_bytes = nr_frame_bytes;
+
+    for (int i = 0; i < 3; ++i) {
+        if (!(buffer->frames[i].data = (uint8_t *)calloc(nr_frame_bytes, 1))) {
+            fprintf(ERROR_FILE, "create_video_triple_buffer: Unable to allocate frames!\n");
+            free_video_triple_buffer(buffer);
+            return false;
+        }
+    }
+
+    if (!(buffer->ready = SDL_CreateSemaphore(0))) {
+        fprintf(ERROR_FILE, "create_video_triple_buffer: Unable to create semaphore: %s!\n", SDL_GetError());
+        free_video_triple_buffer(buffer);
+        return false;
+    }
+
+    //The producer starts writing to frame 0, the consumer holds frame 1, and frame 2 is shared.
+    buffer->write_index = 0;
+    buffer->read_index = 1;
+    SDL_AtomicSet(&buffer->shared, 2);
+
+    return true;
+}
+
+bool free_video_triple_buffer(struct video_triple_buffer *buffer) {
+    if (!buffer) {
+        fprintf(ERROR_FILE, "free_video_triple_buffer: Invalid buffer!\n");
+        return false;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        if (buffer->frames[i].data) free(buffer->frames[i].data);
+    }
+
+    if (buffer->ready) SDL_DestroySemaphore(buffer->ready);
+
+    memset(buffer, 0, sizeof(struct video_triple_buffer));
+
+    return true;
+}
+
+//Copy a frame into the producer's buffer and exchange it with the shared buffer.
+bool video_triple_buffer_write(struct video_triple_buffer *buffer, const void *data, const unsigned width, const unsigned height, const size_t pitch, const size_t bytes_per_pixel) {
+    if (!buffer || !data) return false;
+
+    const size_t nr_row_bytes = (size_t)width*bytes_per_pixel;
+
+    if (nr_row_bytes*height > buffer->nr_frame_bytes || nr_row_bytes > pitch) {
+        fprintf(ERROR_FILE, "video_triple_buffer_write: Frame of %ux%u does not fit!\n", width, height);
+        return false;
+    }
+
+    struct video_frame *f = &buffer->frames[buffer->write_index];
+
+    for (unsigned i = 0; i < height; ++i) memcpy(f->data + i*nr_row_bytes, (const uint8_t *)data + i*pitch, nr_row_bytes);
+
+    f->width = width;
+    f->height = height;
+    f->pitch = nr_row_bytes;
+
+    //SDL_AtomicSet() only has acquire semantics with GCC, so make sure the frame is complete before it becomes visible.
+    SDL_MemoryBarrierRelease();
+    const int shared = SDL_AtomicSet(&buffer->shared, buffer->write_index | TRIPLE_BUFFER_NEW);
+
+    buffer->write_index = shared & 3;
+
+    //Only wake up the consumer once for frames it has not read yet.
+    if (!(shared & TRIPLE_BUFFER_NEW)) SDL_SemPost(buffer->ready);
+
+    return true;
+}
+
+//Return the most recent frame if it has not been read before, otherwise NULL.
+const struct video_frame *video_triple_buffer_read(struct video_triple_buffer *buffer) {
+    if (!buffer || !(SDL_AtomicGet(&buffer->shared) & TRIPLE_BUFFER_NEW)) return NULL;
+
+    buffer->read_index = SDL_AtomicSet(&buffer->shared, buffer->read_index) & 3;
+    SDL_MemoryBarrierAcquire();
+
+    //Consume the wake up for this frame, such that waiting does not return early for frames already read.
+    SDL_SemTryWait(buffer->ready);
+
+    return &buffer->frames[buffer->read_index];
+}
+
+//Wait until a new frame may be available or time_out_ms milliseconds have passed.
+bool video_triple_buffer_wait(struct video_triple_buffer *buffer, const uint32_t time_out_ms) {
+    if (!buffer || !buffer->ready) return false;
+
+    if (SDL_AtomicGet(&buffer->shared) & TRIPLE_BUFFER_NEW) return true;
+
+    return (SDL_SemWaitTimeout(buffer->ready, time_out_ms) == 0);
+}
+
@@ -0,0 +1,156 @@
+/*
+Copyright 2023 Bas Fagginger Auer.
+This file is part of Retro Gauntlet.
+
+Retro Gauntlet is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Retro Gauntlet is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Retro Gauntlet. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "retrogauntlet.h"
+#include "workerpool.h"
+
+//Take and run jobs until the batch is exhausted, must be called with the mutex locked.
+static void worker_pool_run_jobs(struct worker_pool *pool) {
+    while (pool->next_job < pool->nr_jobs) {
+        const size_t i = pool->next_job++;
+        
+        SDL_UnlockMutex(pool->mutex);
+        pool->job(pool->job_data, i);
+        SDL_LockMutex(pool->mutex);
+
+        if (++pool->nr_jobs_done == pool->nr_jobs) SDL_CondBroadcast(pool->done_cond);
+    }
+}
+
+static int worker_pool_thread(void *data) {
+    struct worker_pool *pool = (struct worker_pool *)data;
+
+    SDL_LockMutex(pool->mutex);
+
+    while (!pool->quit) {
+        worker_pool_run_jobs(pool);
+        SDL_CondWait(pool->work_cond, pool->mutex);
+    }
+
+    SDL_UnlockMutex(pool->mutex);
+
+    return 0;
+}
+
+bool create_worker_pool(struct worker_pool *pool, const size_t nr_threads) {
+    if (!pool) {
+        fprintf(ERROR_FILE, "create_worker_pool: Invalid pool!\n");
+        return false;
+    }
+
+    memset(pool, 0, sizeof(struct worker_pool));
+    pool->mutex = SDL_CreateMutex();
+    pool->work_cond = SDL_CreateCond();
+    pool->done_cond = SDL_CreateCond();
+
+    if (!pool->mutex || !pool->work_cond || !pool->done_cond) {
+        fprintf(ERROR_FILE, "create_worker_pool: Unable to create mutex or condition variables: %s!\n", SDL_GetError());
+        free_worker_pool(pool);
+        return false;
+    }
+
+    if (nr_threads > 0) {
+        pool->threads = (SDL_Thread **)calloc(nr_threads, sizeof(SDL_Thread *));
+
+        if (!pool->threads) {
+            fprintf(ERROR_FILE, "create_worker_pool: Unable to allocate threads!\n");
+            free_worker_pool(pool);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < nr_threads; ++i) {
+        pool->threads[i] = SDL_CreateThread(worker_pool_thread, "worker", pool);
+
+        //Continue with fewer threads, the waiting thread can process all jobs by itself.
+        if (!pool->threads[i]) {
+            fprintf(WARN_FILE, "create_worker_pool: Unable to create worker thread: %s!\n", SDL_GetError());
+            break;
+        }
+
+        pool->nr_threads++;
+    }
+
+    fprintf(INFO_FILE, "Created pool with %zu worker threads.\n", pool->nr_threads);
+
+    return true;
+}
+
+bool free_worker_pool(struct worker_pool *pool) {
+    if (!pool) {
+        fprintf(ERROR_FILE, "free_worker_pool: Invalid pool!\n");
+        return false;
+    }
+
+    if (pool->mutex) {
+        SDL_LockMutex(pool->mutex);
+        pool->quit = true;
+        SDL_CondBroadcast(pool->work_cond);
+        SDL_UnlockMutex(pool->mutex);
+    }
+
+    for (size_t i = 0; i < pool->nr_threads; ++i) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+
+    if (pool->threads) free(pool->threads);
+    if (pool->done_cond) SDL_DestroyCond(pool->done_cond);
+    if (pool->work_cond) SDL_DestroyCond(pool->work_cond);
+    if (pool->mutex) SDL_DestroyMutex(pool->mutex);
+
+    memset(pool, 0, sizeof(struct worker_pool));
+
+    return true;
+}
+
+bool worker_pool_start(struct worker_pool *pool, worker_job_t job, void *job_data, const size_t nr_jobs) {
+    if (!pool || !pool->mutex || !job) {
+        fprintf(ERROR_FILE, "worker_pool_start: Invalid pool or job!\n");
+        return false;
+    }
+
+    //Only one batch can be active at a time.
+    worker_pool_wait(pool);
+
+    SDL_LockMutex(pool->mutex);
+    pool->job = job;
+    pool->job_data = job_data;
+    pool->nr_jobs = nr_jobs;
+    pool->next_job = 0;
+    pool->nr_jobs_done = 0;
+    SDL_CondBroadcast(pool->work_cond);
+    SDL_UnlockMutex(pool->mutex);
+
+    return true;
+}
+
+bool worker_pool_wait(struct worker_pool *pool) {
+    if (!pool || !pool->mutex) {
+        fprintf(ERROR_FILE, "worker_pool_wait: Invalid pool!\n");
+        return false;
+    }
+
+    SDL_LockMutex(pool->mutex);
+
+    //Help out with remaining jobs instead of idling.
+    worker_pool_run_jobs(pool);
+
+    while (pool->nr_jobs_done < pool->nr_jobs) {
+        SDL_CondWait(pool->done_cond, pool->mutex);
+    }
+
+    SDL_UnlockMutex(pool->mutex);
+
+    return true;
+}
+